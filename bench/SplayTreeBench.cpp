@@ -0,0 +1,532 @@
+/**
+ * @file SplayTreeBench.cpp
+ * @brief Headless benchmark of SplayTree and CompactSplayTree against std::map and std::set (no Qt needed).
+ *
+ * Every workload loads a set of customer IDs, runs a stream of lookups, walks the whole
+ * structure in order and erases everything again. Each phase is reported as ns/op, the splay
+ * trees also as rotations/op (counted in a second, untimed run), and the load phase with the
+ * resident memory it added. Top-down trees report one restructure per splay instead of single
+ * rotations, as that is how often their observer is told (see RotationKind::TopDown).
+ *
+ * --spine COUNT adds a stress run on a degenerate tree: COUNT ascending inserts leave a single
+ * left spine COUNT nodes deep, which is then measured, copied, printed and destroyed. None of
+ * these may recurse per level, so the run must finish on the default stack.
+ *
+ * Usage: SplayTreeBench [--n COUNT] [--ops COUNT] [--csv PATH] [--workload NAME] [--seed SEED] [--spine COUNT]
+ */
+#include "SplayTree.h"
+#include "CompactSplayTree.h"
+#include <map>
+#include <set>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <numeric>
+#include <ostream>
+#include <streambuf>
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace
+{
+    /**
+     * @brief Same fields and layout as Account, without the Qt dependencies of Account.h.
+     */
+    struct BenchAccount
+    {
+        int customerID;
+        int creditScore;
+        short age;
+        short tenure;
+        double balance;
+        bool isActiveMember;
+    };
+
+    BenchAccount makeAccount(int id)
+    {
+        return { id, 300 + id % 551, static_cast<short>(18 + id % 60), static_cast<short>(id % 11), id * 0.5, (id & 1) != 0 };
+    }
+
+    /**
+     * @brief Observer adding every restructuring step to an external counter.
+     */
+    struct RotationCounter
+    {
+        static constexpr bool enabled = true;
+        size_t* count = nullptr;
+
+        template <class Event>
+        void onRotation(const Event&) { ++*count; }
+    };
+
+    /**
+     * @brief Keys the tree by customer ID, as AccountTraits does. Counted trees also count rotations.
+     */
+    template <SplayMode Mode, bool Counted = false>
+    struct BenchTraits : SplayTraits<BenchAccount>
+    {
+        static constexpr SplayMode mode = Mode;
+        using key_type = int;
+        static key_type keyOf(const BenchAccount& account) { return account.customerID; }
+
+        template <class Node>
+        using observer = std::conditional_t<Counted, RotationCounter, NullSplayObserver>;
+    };
+
+    struct IdLess
+    {
+        using is_transparent = void;
+        bool operator()(const BenchAccount& a, const BenchAccount& b) const { return a.customerID < b.customerID; }
+        bool operator()(const BenchAccount& a, int id) const { return a.customerID < id; }
+        bool operator()(int id, const BenchAccount& b) const { return id < b.customerID; }
+    };
+
+    // ---------------------------------------------------------------- structures under test
+
+    template <class Tree, class CountedTree>
+    struct SplayAdapter
+    {
+        static constexpr bool splays = true;
+        using Counted = SplayAdapter<CountedTree, CountedTree>; ///< Same tree with a RotationCounter.
+        Tree tree;
+
+        void insert(const BenchAccount& account) { tree.insert(account); }
+        bool find(int id) { return tree.search(id) != nullptr; }
+        bool erase(int id) { return tree.erase(id); }
+        long long traverse() const
+        {
+            long long sum = 0;
+            for (const BenchAccount& account : tree)
+                sum += account.customerID;
+            return sum;
+        }
+        void countRotations(size_t* counter) { tree.observer().count = counter; }
+    };
+
+    /**
+     * @brief CompactSplayTree has no observer; its counted twin collects stats and hands the rotations over after every call.
+     */
+    template <class Tree, class CountedTree>
+    struct CompactAdapter
+    {
+        static constexpr bool splays = true;
+        using Counted = CompactAdapter<CountedTree, CountedTree>;
+        Tree tree;
+        size_t* rotations = nullptr;
+
+        void insert(const BenchAccount& account) { tree.insert(account); collect(); }
+        bool find(int id) { bool found = tree.search(id) != nullptr; collect(); return found; }
+        bool erase(int id) { bool erased = tree.erase(id); collect(); return erased; }
+        long long traverse() const
+        {
+            long long sum = 0;
+            for (const BenchAccount& account : tree)
+                sum += account.customerID;
+            return sum;
+        }
+        void countRotations(size_t* counter) { rotations = counter; }
+
+        void collect()
+        {
+            if (!rotations)
+                return;
+            *rotations += tree.stats().rotations;
+            tree.resetStats();
+        }
+    };
+
+    struct MapAdapter
+    {
+        static constexpr bool splays = false;
+        using Counted = MapAdapter;
+        std::map<int, BenchAccount> map;
+
+        void insert(const BenchAccount& account) { map.emplace(account.customerID, account); }
+        bool find(int id) { return map.find(id) != map.end(); }
+        bool erase(int id) { return map.erase(id) != 0; }
+        long long traverse() const
+        {
+            long long sum = 0;
+            for (const auto& entry : map)
+                sum += entry.first;
+            return sum;
+        }
+        void countRotations(size_t*) {}
+    };
+
+    struct SetAdapter
+    {
+        static constexpr bool splays = false;
+        using Counted = SetAdapter;
+        std::set<BenchAccount, IdLess> set;
+
+        void insert(const BenchAccount& account) { set.insert(account); }
+        bool find(int id) { return set.find(id) != set.end(); }
+        bool erase(int id)
+        {
+            auto found = set.find(id);
+            if (found == set.end())
+                return false;
+            set.erase(found);
+            return true;
+        }
+        long long traverse() const
+        {
+            long long sum = 0;
+            for (const BenchAccount& account : set)
+                sum += account.customerID;
+            return sum;
+        }
+        void countRotations(size_t*) {}
+    };
+
+    template <SplayMode Mode>
+    using StdTree = SplayAdapter<SplayTree<BenchAccount, std::allocator<BenchAccount>, BenchTraits<Mode>>,
+                                 SplayTree<BenchAccount, std::allocator<BenchAccount>, BenchTraits<Mode, true>>>;
+
+    using BottomUpTree = StdTree<SplayMode::BottomUp>;
+    using TopDownTree = StdTree<SplayMode::TopDown>;
+    using PooledTree = SplayAdapter<PooledSplayTree<BenchAccount, BenchTraits<SplayMode::BottomUp>>,
+                                    PooledSplayTree<BenchAccount, BenchTraits<SplayMode::BottomUp, true>>>;
+
+    /**
+     * @brief Counted compact trees count through stats, not through an observer.
+     */
+    template <bool Counted>
+    struct CompactTraits : BenchTraits<SplayMode::BottomUp>
+    {
+        static constexpr bool collectStats = Counted;
+    };
+
+    using CompactTree = CompactAdapter<CompactSplayTree<BenchAccount, CompactTraits<false>>,
+                                       CompactSplayTree<BenchAccount, CompactTraits<true>>>;
+
+    // ---------------------------------------------------------------- workloads
+
+    /**
+     * @brief Key streams of one workload: load order, lookups and erase order.
+     */
+    struct Workload
+    {
+        std::string name;
+        vector<int> load;
+        vector<int> lookups;
+        vector<int> erase;
+    };
+
+    vector<int> shuffled(vector<int> keys, std::mt19937& rng)
+    {
+        std::shuffle(keys.begin(), keys.end(), rng);
+        return keys;
+    }
+
+    vector<int> sequentialIds(size_t n)
+    {
+        vector<int> ids(n);
+        std::iota(ids.begin(), ids.end(), 1);
+        return ids;
+    }
+
+    /// IDs handed out one after another, like AccountDAL's counter; uniform lookups.
+    Workload sequential(size_t n, size_t ops, std::mt19937& rng)
+    {
+        Workload w{ "sequential", sequentialIds(n), {}, {} };
+        std::uniform_int_distribution<size_t> pick(0, n - 1);
+        for (size_t i = 0; i < ops; i++)
+            w.lookups.push_back(w.load[pick(rng)]);
+        w.erase = w.load;
+        return w;
+    }
+
+    Workload uniform(size_t n, size_t ops, std::mt19937& rng)
+    {
+        Workload w{ "uniform", shuffled(sequentialIds(n), rng), {}, {} };
+        std::uniform_int_distribution<size_t> pick(0, n - 1);
+        for (size_t i = 0; i < ops; i++)
+            w.lookups.push_back(w.load[pick(rng)]);
+        w.erase = shuffled(w.load, rng);
+        return w;
+    }
+
+    /// Lookups follow a Zipf(0.99) law over the keys in random order, so hot keys are scattered.
+    Workload zipfian(size_t n, size_t ops, std::mt19937& rng)
+    {
+        Workload w{ "zipfian", shuffled(sequentialIds(n), rng), {}, {} };
+        vector<double> cdf(n);
+        double total = 0.0;
+        for (size_t i = 0; i < n; i++)
+            cdf[i] = total += 1.0 / std::pow(static_cast<double>(i + 1), 0.99);
+
+        std::uniform_real_distribution<double> unit(0.0, total);
+        for (size_t i = 0; i < ops; i++) {
+            size_t rank = std::lower_bound(cdf.begin(), cdf.end(), unit(rng)) - cdf.begin();
+            w.lookups.push_back(w.load[std::min(rank, n - 1)]);
+        }
+        w.erase = shuffled(w.load, rng);
+        return w;
+    }
+
+    /// Lookups stay within a working set of 1% of the keys, which moves on ten times.
+    Workload workingSet(size_t n, size_t ops, std::mt19937& rng)
+    {
+        Workload w{ "workingset", shuffled(sequentialIds(n), rng), {}, {} };
+        const size_t setSize = std::max<size_t>(1, n / 100);
+        const size_t phase = std::max<size_t>(1, ops / 10);
+        std::uniform_int_distribution<size_t> pick(0, setSize - 1);
+        std::uniform_int_distribution<size_t> start(0, n - setSize);
+        size_t first = start(rng);
+        for (size_t i = 0; i < ops; i++) {
+            if (i % phase == 0)
+                first = start(rng);
+            w.lookups.push_back(w.load[first + pick(rng)]);
+        }
+        w.erase = shuffled(w.load, rng);
+        return w;
+    }
+
+    /// Customer IDs of the CSV in file order; lookups replay that order until ops is reached.
+    bool csvReplay(const std::string& path, size_t ops, Workload& w)
+    {
+        std::ifstream in(path);
+        if (!in)
+            return false;
+
+        w.name = "csv";
+        std::string line;
+        while (std::getline(in, line)) {
+            char* end = nullptr;
+            long id = std::strtol(line.c_str(), &end, 10);
+            if (end != line.c_str())
+                w.load.push_back(static_cast<int>(id)); // The header line does not parse and is skipped
+        }
+        if (w.load.empty())
+            return false;
+
+        for (size_t i = 0; i < ops; i++)
+            w.lookups.push_back(w.load[i % w.load.size()]);
+        w.erase = w.load;
+        return true;
+    }
+
+    // ---------------------------------------------------------------- measurement
+
+    using Clock = std::chrono::steady_clock;
+
+    double nsPerOp(Clock::time_point start, size_t ops)
+    {
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        return ops ? ns / static_cast<double>(ops) : 0.0;
+    }
+
+    /**
+     * @brief Resident set size in bytes, 0 where it cannot be read.
+     */
+    long long residentBytes()
+    {
+#if defined(__linux__)
+        std::ifstream statm("/proc/self/statm");
+        long long pages = 0, resident = 0;
+        if (statm >> pages >> resident)
+            return resident * sysconf(_SC_PAGESIZE);
+#endif
+        return 0;
+    }
+
+    void trimHeap()
+    {
+#if defined(__GLIBC__)
+        malloc_trim(0);
+#endif
+    }
+
+    struct PhaseResult
+    {
+        double ns = 0.0;
+        double rotations = -1.0; ///< Negative when the structure does not rotate.
+    };
+
+    long long checksum = 0; // Printed at the end so no phase can be optimized away
+
+    template <class Adapter>
+    void run(const Workload& w, const char* structure)
+    {
+        PhaseResult load, lookup, traverse, erase;
+
+        trimHeap();
+        const long long rssBefore = residentBytes();
+        {
+            Adapter* a = new Adapter;
+
+            Clock::time_point start = Clock::now();
+            for (int id : w.load)
+                a->insert(makeAccount(id));
+            load.ns = nsPerOp(start, w.load.size());
+            trimHeap(); // Growing arrays leave their old buffers free in the heap; count only what is live
+            const long long rssLoaded = residentBytes();
+
+            start = Clock::now();
+            for (int id : w.lookups)
+                checksum += a->find(id);
+            lookup.ns = nsPerOp(start, w.lookups.size());
+
+            start = Clock::now();
+            checksum += a->traverse();
+            traverse.ns = nsPerOp(start, w.load.size());
+
+            start = Clock::now();
+            for (int id : w.erase)
+                checksum += a->erase(id);
+            erase.ns = nsPerOp(start, w.erase.size());
+
+            delete a;
+
+            if constexpr (Adapter::splays) {
+                // Same streams again with a rotation counter attached, outside the timed run
+                size_t rotations = 0;
+                typename Adapter::Counted counted;
+                counted.countRotations(&rotations);
+                for (int id : w.load)
+                    counted.insert(makeAccount(id));
+                load.rotations = static_cast<double>(rotations) / w.load.size();
+                rotations = 0;
+                for (int id : w.lookups)
+                    counted.find(id);
+                lookup.rotations = w.lookups.empty() ? 0.0 : static_cast<double>(rotations) / w.lookups.size();
+                traverse.rotations = 0.0;
+                rotations = 0;
+                for (int id : w.erase)
+                    counted.erase(id);
+                erase.rotations = static_cast<double>(rotations) / w.erase.size();
+            }
+
+            const double mb = (rssLoaded - rssBefore) / (1024.0 * 1024.0);
+            const PhaseResult* phases[] = { &load, &lookup, &traverse, &erase };
+            const char* names[] = { "insert", "search", "traverse", "erase" };
+            for (int i = 0; i < 4; i++) {
+                std::printf("%-11s %-10s %-9s %10.1f ns/op", w.name.c_str(), structure, names[i], phases[i]->ns);
+                if (phases[i]->rotations >= 0.0)
+                    std::printf(" %8.2f rot/op", phases[i]->rotations);
+                else
+                    std::printf(" %8s rot/op", "-");
+                if (i == 0)
+                    std::printf(" %9.1f MB", mb);
+                std::printf("\n");
+            }
+        }
+    }
+
+    void runAll(const Workload& w)
+    {
+        run<BottomUpTree>(w, "splay");
+        run<TopDownTree>(w, "splay-td");
+        run<PooledTree>(w, "splay-pool");
+        run<CompactTree>(w, "splay-cmp");
+        run<MapAdapter>(w, "std::map");
+        run<SetAdapter>(w, "std::set");
+    }
+
+    /**
+     * @brief Stream buffer that discards everything, to time the printing walks without I/O.
+     */
+    struct NullBuffer : std::streambuf
+    {
+        int overflow(int c) override { checksum++; return c; }
+    };
+
+    void spine(size_t count)
+    {
+        auto ms = [](Clock::time_point start) {
+            return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        };
+        NullBuffer discard;
+        std::ostream nowhere(&discard);
+
+        std::printf("spine count=%zu\n", count);
+        SplayTree<int>* tree = new SplayTree<int>;
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < count; i++)
+            tree->insert(static_cast<int>(i));
+        std::printf("%-10s %10.1f ms\n", "insert", ms(start));
+
+        start = Clock::now();
+        checksum += tree->height();
+        std::printf("%-10s %10.1f ms  (height %d)\n", "height", ms(start), tree->height());
+
+        start = Clock::now();
+        checksum += static_cast<long long>(tree->depthProfile().size());
+        std::printf("%-10s %10.1f ms\n", "profile", ms(start));
+
+        start = Clock::now();
+        SplayTree<int>* copy = new SplayTree<int>(*tree);
+        std::printf("%-10s %10.1f ms\n", "copy", ms(start));
+
+        start = Clock::now();
+        copy->display(nowhere, 0);
+        copy->display(nowhere, 1);
+        copy->leafNodes(nowhere);
+        std::printf("%-10s %10.1f ms\n", "print", ms(start));
+
+        start = Clock::now();
+        delete copy;
+        delete tree;
+        std::printf("%-10s %10.1f ms\n", "destroy", ms(start));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t n = 1000000;
+    size_t ops = 1000000;
+    unsigned seed = 42;
+    std::string csv = "DummyData/SplayTreeBankAccounts.csv";
+    std::string only;
+    size_t spineCount = 0;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--n")) n = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--ops")) ops = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--csv")) csv = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--workload")) only = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--seed")) seed = static_cast<unsigned>(std::strtoul(argv[i + 1], nullptr, 10));
+        else if (!std::strcmp(argv[i], "--spine")) spineCount = std::strtoull(argv[i + 1], nullptr, 10);
+        else {
+            std::fprintf(stderr, "usage: %s [--n COUNT] [--ops COUNT] [--csv PATH] [--workload NAME] [--seed SEED] [--spine COUNT]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (n == 0) n = 1;
+
+    std::printf("n=%zu ops=%zu seed=%u\n", n, ops, seed);
+    std::printf("%-11s %-10s %-9s %16s %15s %12s\n", "workload", "structure", "phase", "time", "rotations", "load RSS");
+
+    std::mt19937 rng(seed);
+    Workload (*generators[])(size_t, size_t, std::mt19937&) = { sequential, uniform, zipfian, workingSet };
+    for (auto generate : generators) {
+        Workload w = generate(n, ops, rng);
+        if (only.empty() || only == w.name)
+            runAll(w);
+    }
+
+    if (only.empty() || only == "csv") {
+        Workload w;
+        if (csvReplay(csv, ops, w))
+            runAll(w);
+        else
+            std::fprintf(stderr, "skipping csv replay, cannot read %s\n", csv.c_str());
+    }
+
+    if (spineCount)
+        spine(spineCount);
+
+    std::printf("checksum %lld\n", checksum);
+    return 0;
+}
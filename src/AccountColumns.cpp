@@ -0,0 +1,320 @@
+#include "AccountColumns.h"
+#include "SplayTree.h"
+#include <algorithm>
+#include <bitset>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ACCOUNT_COLUMNS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SSE2_TARGET
+#define AVX2_TARGET
+#else
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	inline size_t countBits(int mask)
+	{
+		return bitset<8>(static_cast<unsigned>(mask)).count();
+	}
+
+	inline void add(ColumnScan& total, const ColumnScan& part)
+	{
+		total.matches += part.matches;
+		total.balanceSum += part.balanceSum;
+	}
+}
+
+void AccountColumns::assign(const vector<Account>& accounts)
+{
+	const size_t n = accounts.size();
+	ids.resize(n);
+	creditScores.resize(n);
+	ages.resize(n);
+	tenures.resize(n);
+	balances.resize(n);
+	activeBits.assign((n + 63) / 64, 0);
+	rowOf.clear();
+	rowOf.reserve(n);
+
+	for (size_t row = 0; row < n; row++) {
+		writeRow(row, accounts[row]);
+		rowOf[accounts[row].getCustomerID()] = row;
+	}
+}
+
+void AccountColumns::upsert(const Account& account)
+{
+	auto found = rowOf.find(account.getCustomerID());
+	if (found != rowOf.end()) {
+		writeRow(found->second, account);
+		return;
+	}
+
+	size_t row = ids.size();
+	ids.push_back(0);
+	creditScores.push_back(0);
+	ages.push_back(0);
+	tenures.push_back(0);
+	balances.push_back(0.0);
+	if (activeBits.size() * 64 < ids.size())
+		activeBits.push_back(0);
+	writeRow(row, account);
+	rowOf[account.getCustomerID()] = row;
+}
+
+bool AccountColumns::erase(int id)
+{
+	auto found = rowOf.find(id);
+	if (found == rowOf.end())
+		return false;
+
+	// Move the last row into the hole so the columns stay dense
+	size_t row = found->second;
+	size_t last = ids.size() - 1;
+	rowOf.erase(found);
+	if (row != last) {
+		ids[row] = ids[last];
+		creditScores[row] = creditScores[last];
+		ages[row] = ages[last];
+		tenures[row] = tenures[last];
+		balances[row] = balances[last];
+		setActive(row, isActive(last));
+		rowOf[ids[row]] = row;
+	}
+
+	setActive(last, false);
+	ids.pop_back();
+	creditScores.pop_back();
+	ages.pop_back();
+	tenures.pop_back();
+	balances.pop_back();
+	activeBits.resize((ids.size() + 63) / 64);
+	return true;
+}
+
+void AccountColumns::writeRow(size_t row, const Account& account)
+{
+	ids[row] = account.getCustomerID();
+	creditScores[row] = account.getCreditScore();
+	ages[row] = account.getAge();
+	tenures[row] = account.getTenure();
+	balances[row] = account.getBalance();
+	setActive(row, account.isActive());
+}
+
+void AccountColumns::setActive(size_t row, bool active)
+{
+	uint64_t bit = uint64_t(1) << (row & 63);
+	if (active)
+		activeBits[row >> 6] |= bit;
+	else
+		activeBits[row >> 6] &= ~bit;
+}
+
+ScanKernel AccountColumns::bestKernel()
+{
+#ifdef ACCOUNT_COLUMNS_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+	static const ScanKernel best = []() {
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return ScanKernel::Sse2;
+		__cpuid(info, 1);
+		const bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+		__cpuidex(info, 7, 0);
+		return osSavesYmm && (info[1] & (1 << 5)) ? ScanKernel::Avx2 : ScanKernel::Sse2;
+	}();
+	return best;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return ScanKernel::Avx2;
+	return __builtin_cpu_supports("sse2") ? ScanKernel::Sse2 : ScanKernel::Scalar;
+#endif
+#else
+	return ScanKernel::Scalar;
+#endif
+}
+
+ColumnScan AccountColumns::scan(const ColumnFilter& filter, ScanKernel kernel) const
+{
+	const ScanKernel best = bestKernel();
+	if (kernel == ScanKernel::Auto || static_cast<int>(kernel) > static_cast<int>(best))
+		kernel = best;
+
+	const size_t n = ids.size();
+	const size_t parts = splay_detail::parallelThreads();
+	if (n < parallelScanRows || parts < 2)
+		return scanRows(filter, kernel, 0, n);
+
+	// Slice boundaries on multiples of 64 rows, so each slice starts on a bitmap word
+	vector<size_t> bounds;
+	for (size_t i = 0; i <= parts; i++)
+		bounds.push_back(i == parts ? n : (n * i / parts) & ~size_t(63));
+
+	// The slices run on the tree's shared worker pool instead of threads started per scan
+	vector<ColumnScan> partial(parts);
+	splay_detail::parallelFor(parts, [&](size_t i) { partial[i] = scanRows(filter, kernel, bounds[i], bounds[i + 1]); });
+
+	ColumnScan total;
+	for (const ColumnScan& part : partial)
+		add(total, part);
+	return total;
+}
+
+ColumnScan AccountColumns::scanRows(const ColumnFilter& filter, ScanKernel kernel, size_t begin, size_t end) const
+{
+	switch (kernel) {
+	case ScanKernel::Avx2: return scanAvx2(filter, begin, end);
+	case ScanKernel::Sse2: return scanSse2(filter, begin, end);
+	default:               return scanScalar(filter, begin, end);
+	}
+}
+
+ColumnScan AccountColumns::scanScalar(const ColumnFilter& filter, size_t begin, size_t end) const
+{
+	ColumnScan result;
+	for (size_t row = begin; row < end; row++) {
+		const int score = creditScores[row];
+		const short age = ages[row];
+		const short tenure = tenures[row];
+		const bool keep = score >= filter.minCreditScore && score <= filter.maxCreditScore
+			&& age >= filter.minAge && age <= filter.maxAge
+			&& tenure >= filter.minTenure && tenure <= filter.maxTenure
+			&& (!filter.activeOnly || isActive(row));
+		if (keep) {
+			result.matches++;
+			result.balanceSum += balances[row];
+		}
+	}
+	return result;
+}
+
+#ifdef ACCOUNT_COLUMNS_X86
+
+/**
+ * Four rows per step: a lane is rejected if any field is out of range (or the row is inactive),
+ * and the balances of the other lanes are summed through the negated mask.
+ */
+SSE2_TARGET ColumnScan AccountColumns::scanSse2(const ColumnFilter& filter, size_t begin, size_t end) const
+{
+	// Scalar up to a multiple of 4, so the active flags of each step sit in one bitmap word
+	size_t row = min(end, (begin + 3) & ~size_t(3));
+	ColumnScan result = scanScalar(filter, begin, row);
+
+	const __m128i minScore = _mm_set1_epi32(filter.minCreditScore);
+	const __m128i maxScore = _mm_set1_epi32(filter.maxCreditScore);
+	const __m128i minAge = _mm_set1_epi32(filter.minAge);
+	const __m128i maxAge = _mm_set1_epi32(filter.maxAge);
+	const __m128i minTenure = _mm_set1_epi32(filter.minTenure);
+	const __m128i maxTenure = _mm_set1_epi32(filter.maxTenure);
+	const __m128i bitLanes = _mm_setr_epi32(1, 2, 4, 8);
+	__m128d sumLo = _mm_setzero_pd();
+	__m128d sumHi = _mm_setzero_pd();
+	size_t matches = 0;
+
+	for (; row + 4 <= end; row += 4) {
+		__m128i score = _mm_loadu_si128(reinterpret_cast<const __m128i*>(creditScores.data() + row));
+		__m128i age = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(ages.data() + row));
+		__m128i tenure = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(tenures.data() + row));
+		age = _mm_srai_epi32(_mm_unpacklo_epi16(age, age), 16); // Sign-extend to 32 bits
+		tenure = _mm_srai_epi32(_mm_unpacklo_epi16(tenure, tenure), 16);
+
+		__m128i reject = _mm_or_si128(_mm_cmplt_epi32(score, minScore), _mm_cmpgt_epi32(score, maxScore));
+		reject = _mm_or_si128(reject, _mm_or_si128(_mm_cmplt_epi32(age, minAge), _mm_cmpgt_epi32(age, maxAge)));
+		reject = _mm_or_si128(reject, _mm_or_si128(_mm_cmplt_epi32(tenure, minTenure), _mm_cmpgt_epi32(tenure, maxTenure)));
+		if (filter.activeOnly) {
+			const int bits = static_cast<int>((activeBits[row >> 6] >> (row & 63)) & 0xF);
+			__m128i active = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), bitLanes), bitLanes);
+			reject = _mm_or_si128(reject, _mm_cmpeq_epi32(active, _mm_setzero_si128()));
+		}
+
+		const int rejected = _mm_movemask_ps(_mm_castsi128_ps(reject));
+		if (rejected == 0xF)
+			continue;
+		matches += 4 - countBits(rejected);
+		__m128d rejectLo = _mm_castsi128_pd(_mm_unpacklo_epi32(reject, reject));
+		__m128d rejectHi = _mm_castsi128_pd(_mm_unpackhi_epi32(reject, reject));
+		sumLo = _mm_add_pd(sumLo, _mm_andnot_pd(rejectLo, _mm_loadu_pd(balances.data() + row)));
+		sumHi = _mm_add_pd(sumHi, _mm_andnot_pd(rejectHi, _mm_loadu_pd(balances.data() + row + 2)));
+	}
+
+	double lanes[2];
+	_mm_storeu_pd(lanes, _mm_add_pd(sumLo, sumHi));
+	result.matches += matches;
+	result.balanceSum += lanes[0] + lanes[1];
+	add(result, scanScalar(filter, row, end));
+	return result;
+}
+
+/**
+ * The AVX2 version of scanSse2, eight rows per step.
+ */
+AVX2_TARGET ColumnScan AccountColumns::scanAvx2(const ColumnFilter& filter, size_t begin, size_t end) const
+{
+	size_t row = min(end, (begin + 7) & ~size_t(7));
+	ColumnScan result = scanScalar(filter, begin, row);
+
+	const __m256i minScore = _mm256_set1_epi32(filter.minCreditScore);
+	const __m256i maxScore = _mm256_set1_epi32(filter.maxCreditScore);
+	const __m256i minAge = _mm256_set1_epi32(filter.minAge);
+	const __m256i maxAge = _mm256_set1_epi32(filter.maxAge);
+	const __m256i minTenure = _mm256_set1_epi32(filter.minTenure);
+	const __m256i maxTenure = _mm256_set1_epi32(filter.maxTenure);
+	const __m256i bitLanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	__m256d sumLo = _mm256_setzero_pd();
+	__m256d sumHi = _mm256_setzero_pd();
+	size_t matches = 0;
+
+	for (; row + 8 <= end; row += 8) {
+		__m256i score = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(creditScores.data() + row));
+		__m256i age = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ages.data() + row)));
+		__m256i tenure = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tenures.data() + row)));
+
+		__m256i reject = _mm256_or_si256(_mm256_cmpgt_epi32(minScore, score), _mm256_cmpgt_epi32(score, maxScore));
+		reject = _mm256_or_si256(reject, _mm256_or_si256(_mm256_cmpgt_epi32(minAge, age), _mm256_cmpgt_epi32(age, maxAge)));
+		reject = _mm256_or_si256(reject, _mm256_or_si256(_mm256_cmpgt_epi32(minTenure, tenure), _mm256_cmpgt_epi32(tenure, maxTenure)));
+		if (filter.activeOnly) {
+			const int bits = static_cast<int>((activeBits[row >> 6] >> (row & 63)) & 0xFF);
+			__m256i active = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), bitLanes), bitLanes);
+			reject = _mm256_or_si256(reject, _mm256_cmpeq_epi32(active, _mm256_setzero_si256()));
+		}
+
+		const int rejected = _mm256_movemask_ps(_mm256_castsi256_ps(reject));
+		if (rejected == 0xFF)
+			continue;
+		matches += 8 - countBits(rejected);
+		__m256d rejectLo = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm256_castsi256_si128(reject)));
+		__m256d rejectHi = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm256_extracti128_si256(reject, 1)));
+		sumLo = _mm256_add_pd(sumLo, _mm256_andnot_pd(rejectLo, _mm256_loadu_pd(balances.data() + row)));
+		sumHi = _mm256_add_pd(sumHi, _mm256_andnot_pd(rejectHi, _mm256_loadu_pd(balances.data() + row + 4)));
+	}
+
+	double lanes[4];
+	_mm256_storeu_pd(lanes, _mm256_add_pd(sumLo, sumHi));
+	result.matches += matches;
+	result.balanceSum += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	add(result, scanScalar(filter, row, end));
+	return result;
+}
+
+#else
+
+ColumnScan AccountColumns::scanSse2(const ColumnFilter& filter, size_t begin, size_t end) const
+{
+	return scanScalar(filter, begin, end);
+}
+
+ColumnScan AccountColumns::scanAvx2(const ColumnFilter& filter, size_t begin, size_t end) const
+{
+	return scanScalar(filter, begin, end);
+}
+
+#endif
@@ -0,0 +1,104 @@
+#pragma once
+#include "Account.h"
+#include <vector>
+#include <cstdint>
+#include <climits>
+#include <unordered_map>
+
+using namespace std;
+
+/**
+ * @brief Row predicate of a column scan. Ranges are inclusive; the defaults let every row pass.
+ */
+struct ColumnFilter
+{
+	bool activeOnly = false;
+	int minCreditScore = INT_MIN;
+	int maxCreditScore = INT_MAX;
+	short minAge = SHRT_MIN;
+	short maxAge = SHRT_MAX;
+	short minTenure = SHRT_MIN;
+	short maxTenure = SHRT_MAX;
+};
+
+/**
+ * @brief Result of a column scan: how many rows matched and the sum of their balances.
+ */
+struct ColumnScan
+{
+	size_t matches = 0;
+	double balanceSum = 0.0;
+};
+
+/**
+ * @brief Instruction set a scan runs on. Auto picks the widest one the CPU supports.
+ */
+enum class ScanKernel
+{
+	Auto,
+	Scalar,
+	Sse2,
+	Avx2
+};
+
+/**
+ * @brief Columnar copy of the accounts for predicate-plus-aggregate scans.
+ *
+ * Every field lives in its own contiguous array (active flags in a bitmap), so a scan
+ * streams only the columns it tests and sums, and the SSE2/AVX2 kernels test 4 or 8 rows per
+ * step. Rows are unordered: a new account is appended and an erased row is replaced by the
+ * last one, with a hash map from customer ID to row. Large scans are split across the shared
+ * splay_detail::WorkerPool.
+ */
+class AccountColumns
+{
+public:
+	/**
+	 * @brief Replaces the contents with the accounts.
+	 */
+	void assign(const vector<Account>& accounts);
+
+	/**
+	 * @brief Inserts the account, or overwrites the row with the same ID.
+	 */
+	void upsert(const Account& account);
+
+	/**
+	 * @brief Removes the row of the ID.
+	 * @return False if no such row exists.
+	 */
+	bool erase(int id);
+
+	size_t size() const { return ids.size(); }
+
+	/**
+	 * @brief Counts the rows matching the filter and sums their balances.
+	 * @param kernel Forces an instruction set; one the CPU lacks falls back to the next narrower.
+	 */
+	ColumnScan scan(const ColumnFilter& filter, ScanKernel kernel = ScanKernel::Auto) const;
+
+	/**
+	 * @brief The widest kernel the CPU runs.
+	 */
+	static ScanKernel bestKernel();
+
+private:
+	ColumnScan scanRows(const ColumnFilter& filter, ScanKernel kernel, size_t begin, size_t end) const;
+	ColumnScan scanScalar(const ColumnFilter& filter, size_t begin, size_t end) const;
+	ColumnScan scanSse2(const ColumnFilter& filter, size_t begin, size_t end) const;
+	ColumnScan scanAvx2(const ColumnFilter& filter, size_t begin, size_t end) const;
+
+	bool isActive(size_t row) const { return (activeBits[row >> 6] >> (row & 63)) & 1; }
+	void setActive(size_t row, bool active);
+	void writeRow(size_t row, const Account& account);
+
+	static constexpr size_t parallelScanRows = 1 << 20; ///< Scans at least this long use several threads.
+
+	vector<int32_t> ids;
+	vector<int32_t> creditScores;
+	vector<int16_t> ages;
+	vector<int16_t> tenures;
+	vector<double> balances;
+	vector<uint64_t> activeBits;     ///< Bit (row % 64) of word (row / 64).
+	unordered_map<int, size_t> rowOf;
+};
@@ -0,0 +1,264 @@
+#include "AccountCsvReader.h"
+#include <QFile>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	const double powersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+								  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18 };
+
+	inline void skipSpaces(const char*& p, const char* end)
+	{
+		while (p != end && (*p == ' ' || *p == '\t'))
+			++p;
+	}
+
+	// Moves p past the field separator; false if the row ended instead
+	inline bool nextField(const char*& p, const char* end)
+	{
+		skipSpaces(p, end);
+		if (p == end || *p != ',')
+			return false;
+		++p;
+		return true;
+	}
+
+	/**
+	 * @brief Parses a decimal number ([sign] digits [. digits] [e exponent]) without allocating.
+	 * @return False if no digit was found.
+	 */
+	bool parseDouble(const char*& p, const char* end, double& value)
+	{
+		skipSpaces(p, end);
+		bool negative = false;
+		if (p != end && (*p == '-' || *p == '+'))
+			negative = (*p++ == '-');
+
+		unsigned long long mantissa = 0;
+		int digits = 0;
+		int scale = 0;
+		bool any = false;
+		for (; p != end && *p >= '0' && *p <= '9'; ++p, any = true)
+		{
+			if (digits < 18) { mantissa = mantissa * 10 + (*p - '0'); if (mantissa) digits++; }
+			else scale++; // Beyond double precision, only the magnitude matters
+		}
+		if (p != end && *p == '.')
+		{
+			for (++p; p != end && *p >= '0' && *p <= '9'; ++p, any = true)
+			{
+				if (digits < 18) { mantissa = mantissa * 10 + (*p - '0'); if (mantissa) digits++; scale--; }
+			}
+		}
+		if (!any)
+			return false;
+
+		if (p != end && (*p == 'e' || *p == 'E'))
+		{
+			const char* q = p + 1;
+			bool negativeExp = false;
+			if (q != end && (*q == '-' || *q == '+'))
+				negativeExp = (*q++ == '-');
+			if (q != end && *q >= '0' && *q <= '9')
+			{
+				int exponent = 0;
+				for (; q != end && *q >= '0' && *q <= '9'; ++q)
+					if (exponent < 1000) exponent = exponent * 10 + (*q - '0');
+				scale += negativeExp ? -exponent : exponent;
+				p = q;
+			}
+		}
+
+		double result = static_cast<double>(mantissa);
+		while (scale > 18) { result *= 1e18; scale -= 18; }
+		while (scale < -18) { result /= 1e18; scale += 18; }
+		result = scale >= 0 ? result * powersOf10[scale] : result / powersOf10[-scale];
+		value = negative ? -result : result;
+		return true;
+	}
+
+	/**
+	 * @brief Parses an integer field; a fractional part such as "42.0" is accepted and truncated.
+	 * @return False if the field is not a number or does not fit in Int.
+	 */
+	template <class Int>
+	bool parseInt(const char*& p, const char* end, Int& value)
+	{
+		skipSpaces(p, end);
+		bool negative = false;
+		if (p != end && (*p == '-' || *p == '+'))
+			negative = (*p++ == '-');
+
+		const long long limit = negative ? -static_cast<long long>(numeric_limits<Int>::min())
+			: static_cast<long long>(numeric_limits<Int>::max());
+		long long result = 0;
+		bool any = false;
+		for (; p != end && *p >= '0' && *p <= '9'; ++p, any = true)
+			if ((result = result * 10 + (*p - '0')) > limit)
+				return false; // Stops before result itself can overflow
+		if (p != end && *p == '.')
+			for (++p; p != end && *p >= '0' && *p <= '9'; ++p, any = true) {}
+		if (!any)
+			return false;
+
+		value = static_cast<Int>(negative ? -result : result);
+		return true;
+	}
+
+	/**
+	 * @brief Parses the active flag: a number (only 1, e.g. "1.0", is active) or true/false.
+	 */
+	bool parseFlag(const char*& p, const char* end, bool& value)
+	{
+		skipSpaces(p, end);
+		if (p != end && (*p == 't' || *p == 'T' || *p == 'f' || *p == 'F'))
+		{
+			value = (*p == 't' || *p == 'T');
+			while (p != end && ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z')))
+				++p;
+			return true;
+		}
+		double number;
+		if (!parseDouble(p, end, number))
+			return false;
+		value = (number == 1.0);
+		return true;
+	}
+
+	inline const char* skipLine(const char* p, const char* end)
+	{
+		const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+		return newline ? newline + 1 : end;
+	}
+}
+
+AccountCsvReader::AccountCsvReader(int threads) : threads(threads)
+{
+	if (this->threads <= 0)
+		this->threads = max(1, static_cast<int>(thread::hardware_concurrency()));
+}
+
+bool AccountCsvReader::parseRow(const char*& p, const char* end, Account& account)
+{
+	const char* lineEnd = skipLine(p, end);
+	const char* fieldEnd = lineEnd;
+	while (fieldEnd != p && (fieldEnd[-1] == '\n' || fieldEnd[-1] == '\r'))
+		--fieldEnd;
+
+	int id, creditScore;
+	short age, tenure;
+	double balance;
+	bool active;
+	const char* q = p;
+	bool ok = parseInt(q, fieldEnd, id) && nextField(q, fieldEnd)
+		&& parseInt(q, fieldEnd, creditScore) && nextField(q, fieldEnd)
+		&& parseInt(q, fieldEnd, age) && nextField(q, fieldEnd)
+		&& parseInt(q, fieldEnd, tenure) && nextField(q, fieldEnd)
+		&& parseDouble(q, fieldEnd, balance) && nextField(q, fieldEnd)
+		&& parseFlag(q, fieldEnd, active);
+
+	p = lineEnd;
+	if (!ok)
+		return false;
+
+	account = Account(id, creditScore, age, tenure, balance, active);
+	return true;
+}
+
+size_t AccountCsvReader::parseChunk(const char* begin, const char* end, vector<Account>& out)
+{
+	size_t skipped = 0;
+	Account account;
+	const char* p = begin;
+	while (p != end)
+	{
+		if (*p == '\n' || *p == '\r')
+		{
+			++p; // Blank line
+			continue;
+		}
+		if (parseRow(p, end, account))
+			out.push_back(account);
+		else
+			skipped++;
+	}
+	return skipped;
+}
+
+bool AccountCsvReader::read(const QString& filePath, vector<Account>& out, CsvIngestStats* stats) const
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	QFile file(filePath);
+	if (!file.open(QIODevice::ReadOnly)) {
+		qWarning() << "Could not open file:" << filePath;
+		return false;
+	}
+
+	const qint64 size = file.size();
+	const char* data = nullptr;
+	if (size > 0) {
+		data = reinterpret_cast<const char*>(file.map(0, size));
+		if (!data) {
+			qWarning() << "Could not map file:" << filePath << file.errorString();
+			return false;
+		}
+	}
+
+	const char* end = data + size;
+	const char* body = data ? skipLine(data, end) : end; // Skip header
+
+	// Newline-aligned chunks; tiny files are not worth a thread each
+	const size_t bodyBytes = static_cast<size_t>(end - body);
+	const size_t minChunk = 1 << 20;
+	size_t parts = min(static_cast<size_t>(threads), max<size_t>(1, bodyBytes / minChunk));
+
+	vector<const char*> bounds{ body };
+	for (size_t i = 1; i < parts; i++) {
+		const char* cut = skipLine(body + bodyBytes * i / parts - 1, end); // First line starting at or after the split point
+		bounds.push_back(max(cut, bounds.back()));
+	}
+	bounds.push_back(end);
+
+	vector<vector<Account>> results(parts);
+	vector<size_t> skipped(parts, 0);
+	auto work = [&](size_t i) {
+		results[i].reserve(static_cast<size_t>(bounds[i + 1] - bounds[i]) / 32);
+		skipped[i] = parseChunk(bounds[i], bounds[i + 1], results[i]);
+	};
+
+	vector<thread> workers;
+	for (size_t i = 1; i < parts; i++)
+		workers.emplace_back(work, i);
+	work(0);
+	for (thread& worker : workers)
+		worker.join();
+
+	size_t total = 0;
+	for (const vector<Account>& part : results)
+		total += part.size();
+	out.reserve(out.size() + total);
+	for (const vector<Account>& part : results)
+		out.insert(out.end(), part.begin(), part.end());
+
+	if (data)
+		file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+	file.close();
+
+	if (stats) {
+		stats->bytes = static_cast<size_t>(size);
+		stats->rows = total;
+		stats->skipped = 0;
+		for (size_t s : skipped)
+			stats->skipped += s;
+		stats->threads = static_cast<int>(parts);
+		stats->seconds = timer.nsecsElapsed() / 1e9;
+	}
+	return true;
+}
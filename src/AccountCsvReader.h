@@ -0,0 +1,67 @@
+#pragma once
+#include "Account.h"
+#include <vector>
+#include <cstddef>
+#include <QString>
+
+using namespace std;
+
+/**
+ * @brief Throughput figures of one CSV import.
+ */
+struct CsvIngestStats
+{
+	size_t bytes = 0;      ///< Size of the mapped file.
+	size_t rows = 0;       ///< Accounts parsed (header and malformed rows excluded).
+	size_t skipped = 0;    ///< Non-empty rows that did not have six numeric fields.
+	int threads = 0;       ///< Worker threads used.
+	double seconds = 0.0;  ///< Wall time from open to the finished account array.
+
+	double rowsPerSecond() const { return seconds > 0 ? rows / seconds : 0.0; }
+	double megabytesPerSecond() const { return seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0; }
+};
+
+/**
+ * @brief Bulk CSV importer for account files.
+ *
+ * The file is memory-mapped and split into newline-aligned chunks, one per worker thread.
+ * Each worker parses its chunk straight from the mapped bytes with allocation-free number
+ * parsers into its own Account array; the arrays are then concatenated in file order.
+ * No QString, QStringList or line buffer is created per row.
+ *
+ * Expected columns: CustomerId,CreditScore,Age,Tenure,Balance,IsActiveMember with a header
+ * line. Age and the active flag may be written as decimals ("42.0", "1.0"); the flag also
+ * accepts true/false.
+ */
+class AccountCsvReader
+{
+public:
+	/**
+	 * @param threads Number of worker threads, 0 picks one per hardware thread.
+	 */
+	explicit AccountCsvReader(int threads = 0);
+
+	/**
+	 * @brief Parses a whole CSV file and appends the accounts to out in file order.
+	 * @param filePath Path of the CSV file.
+	 * @param out Receives the accounts.
+	 * @param stats Optional throughput report.
+	 * @return False if the file could not be opened or mapped.
+	 */
+	bool read(const QString& filePath, vector<Account>& out, CsvIngestStats* stats = nullptr) const;
+
+	/**
+	 * @brief Parses the rows in [begin, end), which must start at a line boundary.
+	 * @return Number of non-empty rows that were skipped as malformed.
+	 */
+	static size_t parseChunk(const char* begin, const char* end, vector<Account>& out);
+
+	/**
+	 * @brief Parses one row starting at p and advances p past its line break.
+	 * @return True if the row held a valid account.
+	 */
+	static bool parseRow(const char*& p, const char* end, Account& account);
+
+private:
+	int threads;
+};
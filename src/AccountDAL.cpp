@@ -2,13 +2,46 @@
 
 int AccountDAL::accountCount = 15815690;
 
-AccountDAL::AccountDAL() {
-	getAccountsFromCsv();
+namespace
+{
+	const QString dataDirectory = /*QDir::currentPath()+*/ "C:/Users/lenovo thinkpad E15/Desktop/fundamentals c++/SplayTreeDemo/DummyData/";
+	const QString csvPath = dataDirectory + "SplayTreeBankAccounts.csv";
+	const QString snapshotPath = dataDirectory + "SplayTreeBankAccounts.snap";
+	const QString journalPath = dataDirectory + "SplayTreeBankAccounts.journal";
+}
+
+AccountDAL::AccountDAL() : journal(new AccountJournal(journalPath)) {
+	// The CSV is only an import format: once imported, startup reads the binary snapshot
+	if (!loadSnapshot(snapshotPath)) {
+		getAccountsFromCsv();
+		saveSnapshot(snapshotPath);
+	}
+	replayJournal();
+	journal->open();
 }
 
-void AccountDAL::addAcount(Account acc)
+AccountDAL::~AccountDAL() {
+	delete journal; // Syncs the last group of mutations
+	delete accounts;
+}
+
+void AccountDAL::addAcount(const Account& acc)
 {
-	accounts->insert(acc);
+	if (accounts->try_emplace(acc.getCustomerID(), acc).second) {
+		journal->append(AccountJournal::Op::Upsert, acc);
+		upsertViews(acc);
+		indexes.insert(acc);
+	}
+}
+
+void AccountDAL::addAcount(Account&& acc)
+{
+	auto inserted = accounts->try_emplace(acc.getCustomerID(), std::move(acc));
+	if (inserted.second) {
+		journal->append(AccountJournal::Op::Upsert, inserted.first->data);
+		upsertViews(inserted.first->data);
+		indexes.insert(inserted.first->data);
+	}
 }
 
 
@@ -38,12 +71,19 @@ void AccountDAL::addAccount(int creditScore, short age, short tenure, double bal
 	// Generate a new unique ID
 	int newId = ++accountCount;
 
-	// Create the account object
-	Account newAccount(newId, creditScore, age, tenure, balance, isActiveMember);
-
-	// Insert into the splay tree
+	// Insert into the splay tree, constructing the account directly in its node
 	if (accounts) {
-		accounts->insert(newAccount);
+		auto inserted = accounts->emplace(newId, creditScore, age, tenure, balance, isActiveMember);
+		if (!inserted.second) {
+			// The ID is already taken; leave the existing account, the journal and the views alone
+			qWarning() << "Account ID" << newId << "is already in use.";
+			QMessageBox::critical(nullptr, "Error", QString("Failed to add account. ID %1 is already in use.").arg(newId));
+			return;
+		}
+
+		journal->append(AccountJournal::Op::Upsert, inserted.first->data);
+		upsertViews(inserted.first->data);
+		indexes.insert(inserted.first->data);
 
 		qDebug() << "Inserted account with ID:" << newId;
 		QMessageBox::information(nullptr, "Success",
@@ -58,87 +98,191 @@ void AccountDAL::addAccount(int creditScore, short age, short tenure, double bal
 
 Account* AccountDAL::getAccountyId(int id)
 {
+	if (!splayOnRead)
+		return accounts->peek(id);
+
 	auto foundNode = accounts->search(id);
 	if (foundNode)
 		return &foundNode->data;
 	return nullptr;
 }
 
+const Account* AccountDAL::findAccount(int id) const
+{
+	return static_cast<const AccountBook*>(accounts)->peek(id);
+}
+
+bool AccountDAL::hasAccount(int id) const
+{
+	return accounts->contains(id);
+}
+
 bool AccountDAL::deleteAccount(int id)
 {
-	// auto instead of SplayTree<Account>::Node* for simplicity
-	auto foundNode = accounts->search(id);
-	if (foundNode)
-	{
-		accounts->erase(foundNode->data);
-		return true;
+	// The index entries are keyed by the old field values, so read them before the erase
+	const Account* stored = accounts->peek(id);
+	if (!stored)
+		return false;
+	indexes.erase(*stored);
+	accounts->erase(id);
+	journal->append(AccountJournal::Op::Erase, Account(id));
+	eraseFromViews(id);
+	return true;
+}
+
+size_t AccountDAL::closeAccountRange(int firstId, int lastId)
+{
+	if (lastId < firstId)
+		return 0;
+
+	// Journal the closed IDs first, then cut the whole block out of the tree in one go
+	const AccountBook& tree = *accounts;
+	for (auto it = tree.lower_bound(firstId); it != tree.end() && it->getCustomerID() <= lastId; ++it) {
+		journal->append(AccountJournal::Op::Erase, Account(it->getCustomerID()));
+		eraseFromViews(it->getCustomerID());
+		indexes.erase(*it);
 	}
-	return false;
+	return accounts->eraseRange(firstId, lastId);
 }
 
-bool AccountDAL::updateAccount(Account acc)
+bool AccountDAL::updateAccount(const Account& acc)
 {
-	auto foundNode = accounts->search(acc);
+	auto foundNode = accounts->search(acc.getCustomerID());
 	if (foundNode)
 	{
+		indexes.update(foundNode->data, acc);
 		foundNode->data = acc;  // Overwrite the old data with the new one
+		accounts->refreshAugments(foundNode);
+		journal->append(AccountJournal::Op::Upsert, acc);
+		upsertViews(acc);
 		return true;
 	}
 	return false;
 }
 
-vector<Account> AccountDAL::getAllAccounts()
+vector<Account> AccountDAL::getAllAccounts() const
 {
 	vector<Account> vec;
 	accounts->collectInOrder(vec);
 	return vec;
 }
 
+vector<Account> AccountDAL::getAccountsPage(size_t page, size_t pageSize) const
+{
+	vector<Account> rows;
+	const AccountBook& tree = *accounts;
+	auto it = tree.select(page * pageSize);
+	for (; it != tree.end() && rows.size() < pageSize; ++it)
+		rows.push_back(*it);
+	return rows;
+}
 
-SplayTree<Account> AccountDAL::getDemoAccounts()
+size_t AccountDAL::countAccountsInRange(int firstId, int lastId) const
 {
-	SplayTree<Account> accounts;
+	return accounts->countInRange(firstId, lastId);
+}
 
-	accounts.insert(Account(101, 750, 30, 5, 15000.50, true));
-	accounts.insert(Account(102, 680, 25, 2, 2000.75, true));
-	accounts.insert(Account(103, 720, 40, 10, 12000.00, false));
-	accounts.insert(Account(104, 650, 35, 7, 8000.90, true));
-	accounts.insert(Account(105, 100, 28, 3, 30000.60, true));
-	accounts.insert(Account(106, 1000, 36, 5, 45230.75, true));
-	accounts.insert(Account(107, 234, 42, 10, 12800.00, true));
-	accounts.insert(Account(108, 123, 29, 2, 95320.10, true));
-	accounts.insert(Account(109, 1023, 50, 12, 34000.50, true));
-	accounts.insert(Account(110, 60, 23, 1, 18760.25, true));
+double AccountDAL::idPercentile(int id) const
+{
+	if (accounts->nodeCount() <= 1)
+		return 0.0;
+	return min(1.0, static_cast<double>(accounts->rank(id)) / (accounts->nodeCount() - 1));
+}
 
+AccountSummary AccountDAL::aggregateRange(int firstId, int lastId) const
+{
+	return accounts->aggregateRange(firstId, lastId);
+}
 
-	return accounts;
+void AccountDAL::enableIndex(AccountField field)
+{
+	if (!indexes.isEnabled(field))
+		indexes.enable(field, getAllAccounts());
 }
 
- SplayTree<Account>* AccountDAL::readAccountsFromCsv(const QString& filePath) {
-	QFile file(filePath);
+void AccountDAL::disableIndex(AccountField field)
+{
+	indexes.disable(field);
+}
 
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-		qWarning() << "Could not open file:" << filePath;
-		return accounts;
+vector<Account> AccountDAL::findAccountsInRange(AccountField field, double lo, double hi) const
+{
+	vector<Account> found;
+	if (indexes.isEnabled(field)) {
+		for (int id : indexes.idsInRange(field, lo, hi))
+			found.push_back(*findAccount(id));
+		return found;
 	}
 
-	QTextStream in(&file);
-	bool firstLine = true; // Skip header
+	forEachAccount([&](const Account& acc) {
+		double value = AccountIndexes::fieldValue(acc, field);
+		if (value >= lo && value <= hi)
+			found.push_back(acc);
+	});
+	// Same order as the index: by field value, IDs already ascending within equal values
+	stable_sort(found.begin(), found.end(), [field](const Account& a, const Account& b) {
+		return AccountIndexes::fieldValue(a, field) < AccountIndexes::fieldValue(b, field);
+	});
+	return found;
+}
 
-	while (!in.atEnd()) {
-		QString line = in.readLine();
-		if (firstLine) {
-			firstLine = false;
-			continue;
-		}
+size_t AccountDAL::countAccountsInRange(AccountField field, double lo, double hi) const
+{
+	if (indexes.isEnabled(field))
+		return indexes.countInRange(field, lo, hi);
 
-		Account account(line);
-		//if (account.isValid()) {
-			accounts->insert(account);
-		//}
-	}
-	
-	file.close();
+	size_t count = 0;
+	forEachAccount([&](const Account& acc) {
+		double value = AccountIndexes::fieldValue(acc, field);
+		if (value >= lo && value <= hi)
+			count++;
+	});
+	return count;
+}
+
+vector<Account> AccountDAL::getDemoAccountList()
+{
+	return {
+		Account(101, 750, 30, 5, 15000.50, true),
+		Account(102, 680, 25, 2, 2000.75, true),
+		Account(103, 720, 40, 10, 12000.00, false),
+		Account(104, 650, 35, 7, 8000.90, true),
+		Account(105, 100, 28, 3, 30000.60, true),
+		Account(106, 1000, 36, 5, 45230.75, true),
+		Account(107, 234, 42, 10, 12800.00, true),
+		Account(108, 123, 29, 2, 95320.10, true),
+		Account(109, 1023, 50, 12, 34000.50, true),
+		Account(110, 60, 23, 1, 18760.25, true)
+	};
+}
+
+AccountTree AccountDAL::getDemoAccounts()
+{
+	AccountTree accounts;
+
+	for (const Account& acc : getDemoAccountList())
+		accounts.insert(acc);
+
+	return accounts;
+}
+
+ AccountBook* AccountDAL::readAccountsFromCsv(const QString& filePath) {
+	vector<Account> rows;
+	CsvIngestStats stats;
+	if (!AccountCsvReader().read(filePath, rows, &stats))
+		return accounts;
+
+	qDebug() << "parsed" << stats.rows << "accounts (" << stats.skipped << "skipped ) in" << stats.seconds * 1000 << "ms on"
+		<< stats.threads << "threads:" << stats.rowsPerSecond() << "rows/s," << stats.megabytesPerSecond() << "MB/s";
+
+	// Never hand out an ID the file already holds
+	for (const Account& row : rows)
+		if (row.getCustomerID() > accountCount)
+			accountCount = row.getCustomerID();
+
+	// One sort and a linear balanced build instead of a splaying insert per row
+	accounts->mergeFrom(std::move(rows));
+	rebuildViews();
 	
 	qDebug() << "accounts in tree:" << accounts->nodeCount();
 	
@@ -147,11 +291,174 @@ SplayTree<Account> AccountDAL::getDemoAccounts()
 
 void AccountDAL::getAccountsFromCsv()
 {
-	QString csvPath = /*QDir::currentPath()+*/ "C:/Users/lenovo thinkpad E15/Desktop/fundamentals c++/SplayTreeDemo/DummyData/SplayTreeBankAccounts.csv";
 	this->accounts = readAccountsFromCsv(csvPath);
 }
 
-bool AccountDAL::isEmpty()
+bool AccountDAL::saveSnapshot(const QString& filePath)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	vector<Account> sorted;
+	sorted.reserve(accounts->nodeCount());
+	accounts->collectInOrder(sorted);
+	if (!AccountSnapshot::save(filePath, sorted))
+		return false;
+
+	qDebug() << "saved snapshot of" << sorted.size() << "accounts in" << timer.elapsed() << "ms";
+	return true;
+}
+
+bool AccountDAL::loadSnapshot(const QString& filePath)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	vector<Account> sorted;
+	if (!AccountSnapshot::load(filePath, sorted))
+		return false;
+
+	if (!sorted.empty() && sorted.back().getCustomerID() > accountCount)
+		accountCount = sorted.back().getCustomerID(); // Never hand out an ID the snapshot already holds
+
+	// Records are stored in ID order, so the tree is linked without sorting
+	accounts->buildFrom(std::move(sorted));
+	rebuildViews();
+
+	qDebug() << "loaded snapshot of" << accounts->nodeCount() << "accounts in" << timer.elapsed() << "ms";
+	return true;
+}
+
+void AccountDAL::replayJournal()
+{
+	// Runs from the constructor, before any secondary index can be enabled
+	size_t replayed = journal->replay([this](AccountJournal::Op op, const Account& account) {
+		if (op == AccountJournal::Op::Upsert) {
+			accounts->insert_or_assign(account);
+			upsertViews(account);
+		}
+		else if (op == AccountJournal::Op::Erase) {
+			accounts->erase(account.getCustomerID());
+			eraseFromViews(account.getCustomerID());
+		}
+
+		if (account.getCustomerID() > accountCount)
+			accountCount = account.getCustomerID();
+	});
+	if (replayed)
+		qDebug() << "replayed" << replayed << "journaled changes";
+	if (journal->isDamaged())
+		QMessageBox::critical(nullptr, "Journal Damaged",
+			"The change journal is damaged, so the changes since the last checkpoint were not restored.\n"
+			"It is kept next to the new journal as a .damaged file.");
+}
+
+void AccountDAL::rebuildViews()
+{
+	// Only views already in use are rebuilt, so a cold start is the snapshot read and one buildFrom.
+	// Readers holding older versions keep them; the new version shares nothing with them
+	if (versionsBuilt) {
+		const AccountBook& tree = *accounts;
+		versions.buildFrom(tree.begin(), static_cast<size_t>(tree.nodeCount()));
+	}
+	if (indexes.anyEnabled())
+		indexes.rebuild(getAllAccounts());
+	if (columnsBuilt)
+		columns.assign(getAllAccounts());
+}
+
+AccountVersion AccountDAL::snapshotAccounts() const
+{
+	// A splay tree restructures on every access, so no frozen version can share its nodes: the
+	// versioned copy is a second tree of all accounts, only paid for once somebody takes a snapshot
+	if (!versionsBuilt) {
+		const AccountBook& tree = *accounts;
+		versions.buildFrom(tree.begin(), static_cast<size_t>(tree.nodeCount()));
+		versionsBuilt = true;
+	}
+	return versions.snapshot();
+}
+
+ColumnScan AccountDAL::scanAccounts(const ColumnFilter& filter) const
+{
+	if (!columnsBuilt) {
+		columns.assign(getAllAccounts());
+		columnsBuilt = true;
+	}
+	return columns.scan(filter);
+}
+
+void AccountDAL::upsertViews(const Account& acc)
+{
+	if (versionsBuilt)
+		versions.insert_or_assign(acc);
+	if (columnsBuilt)
+		columns.upsert(acc);
+}
+
+void AccountDAL::eraseFromViews(int id)
+{
+	if (versionsBuilt)
+		versions.erase(id);
+	if (columnsBuilt)
+		columns.erase(id);
+}
+
+bool AccountDAL::checkpoint()
+{
+	// Every journaled change must be in the tree and on disk before the journal may go
+	if (!journal->sync() || !saveSnapshot(snapshotPath))
+		return false;
+	return journal->reset();
+}
+
+unique_ptr<AccountStore> AccountDAL::makeShardedStore(size_t shardCount) const
+{
+	auto store = make_unique<AccountStore>(shardCount, accountCount);
+	store->load(getAllAccounts());
+	return store;
+}
+
+bool AccountDAL::isEmpty() const
 {
 	return accounts->empty();
 }
+
+vector<size_t> AccountDAL::treeDepthProfile(size_t sampleCount) const
+{
+	size_t count = static_cast<size_t>(accounts->nodeCount());
+	size_t stride = (sampleCount == 0 || count <= sampleCount) ? 1 : count / sampleCount;
+	return accounts->depthProfile(stride);
+}
+
+QString AccountDAL::exportTreeStats() const
+{
+	SplayStats stats = treeStats();
+	QString out;
+	QTextStream csv(&out);
+	auto line = [&csv](const QString& metric, qulonglong value) { csv << metric << ',' << value << '\n'; };
+
+	csv << "metric,value\n";
+	line("live_nodes", stats.liveNodes);
+	line("node_bytes", stats.nodeBytes);
+	line("height", static_cast<qulonglong>(treeHeight()));
+	if (AccountBookTraits::collectStats)
+	{
+		line("comparisons", stats.comparisons);
+		line("rotations", stats.rotations);
+		line("zig_steps", stats.zigSteps);
+		line("zig_zig_steps", stats.zigZigSteps);
+		line("zig_zag_steps", stats.zigZagSteps);
+		line("lookup_hits", stats.hits);
+		line("lookup_misses", stats.misses);
+		for (size_t depth = 0; depth < SplayStats::depthBuckets; depth++)
+			if (stats.accessDepth[depth])
+				line(QString("access_depth_%1").arg(depth), stats.accessDepth[depth]);
+	}
+
+	vector<size_t> profile = treeDepthProfile();
+	for (size_t depth = 0; depth < profile.size(); depth++)
+		if (profile[depth])
+			line(QString("sampled_depth_%1").arg(depth), profile[depth]);
+	return out;
+}
@@ -1,6 +1,14 @@
 #pragma once
 #include "Account.h"
 #include "SplayTree.h"
+#include "AccountTree.h"
+#include "AccountCsvReader.h"
+#include "AccountSnapshot.h"
+#include "AccountJournal.h"
+#include "AccountStore.h"
+#include "AccountIndex.h"
+#include "AccountColumns.h"
+#include <memory>
 #include <vector>
 #include <QString> 
 #include <QStringList>
@@ -8,6 +16,7 @@
 #include <QTextStream>
 #include <QDebug> 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QMessageBox>
 
 using namespace std;
@@ -16,8 +25,14 @@ class AccountDAL
 {
 public:
 	AccountDAL();
+	~AccountDAL();
 
-	void addAcount(Account acc);
+	AccountDAL(const AccountDAL&) = delete;
+	AccountDAL& operator=(const AccountDAL&) = delete;
+
+	void addAcount(const Account& acc);
+
+	void addAcount(Account&& acc);
 
 	/*    
 	int customerID;
@@ -31,26 +46,203 @@ public:
 	/*
 	*  @param id of the desired account
 	*  @return returns a pointer to the desired account
-	*  @warning Splays the account to top
+	*  @warning Splays the account to top unless splaying on reads is turned off
+	*  @warning Change accounts through updateAccount, not through this pointer, or the journal and range totals miss it
 	*/
 	Account* getAccountyId(int id);
 
+	/*
+	*  @param id of the desired account
+	*  @return returns a pointer to the desired account, nullptr if absent
+	*  @note Read-only: never restructures the tree
+	*/
+	const Account* findAccount(int id) const;
+
+	bool hasAccount(int id) const;
+
+	/*
+	*  @brief Chooses whether getAccountyId splays (default) or uses the read-only lookup
+	*/
+	void setSplayOnRead(bool enabled) { splayOnRead = enabled; }
+
 	bool deleteAccount(int id);
 
-	bool updateAccount(Account updated);
+	/*
+	*  @brief Closes every account with an ID in [firstId, lastId] at once
+	*  @return Number of accounts closed
+	*/
+	size_t closeAccountRange(int firstId, int lastId);
+
+	bool updateAccount(const Account& updated);
+
+	vector<Account> getAllAccounts() const;
+
+	/*
+	*  @brief Calls visit(const Account&) for every account in ID order without copying them
+	*/
+	template <class Visit>
+	void forEachAccount(Visit visit) const
+	{
+		for (const Account& acc : *static_cast<const AccountBook*>(accounts))
+			visit(acc);
+	}
+
+	/*
+	*  @brief Sums value(const Account&) over every account on all cores, e.g. a full-book valuation
+	*  @note value is called concurrently from several threads
+	*/
+	template <class Value>
+	double valuateAccounts(Value value) const
+	{
+		return accounts->parallelReduce(0.0, value, [](double a, double b) { return a + b; });
+	}
+
+	/*
+	*  @brief Totals as in aggregateRange, over the accounts matching the predicate, on all cores
+	*  @note matches is called concurrently from several threads
+	*/
+	template <class Predicate>
+	AccountSummary summarizeAccounts(Predicate matches) const
+	{
+		return accounts->parallelReduce(AccountSummary(),
+			[&matches](const Account& acc) { return matches(acc) ? AccountTraits::measure(acc) : AccountSummary(); },
+			&AccountTraits::combine);
+	}
+
+	/*
+	*  @brief One page of the accounts in ID order, found in O(log n) instead of by a scan
+	*  @param page Zero-based page index
+	*  @return Up to pageSize accounts, empty past the last page
+	*/
+	vector<Account> getAccountsPage(size_t page, size_t pageSize) const;
+
+	/*
+	*  @brief Number of accounts with an ID in [firstId, lastId]
+	*/
+	size_t countAccountsInRange(int firstId, int lastId) const;
+
+	/*
+	*  @brief Position of the ID among all account IDs, from 0 (smallest) to 1 (largest)
+	*/
+	double idPercentile(int id) const;
+
+	/*
+	*  @brief Account count, active members, balance total and credit score range over IDs [firstId, lastId]
+	*  @note Served from the per-subtree summaries in the tree, without visiting every account
+	*/
+	AccountSummary aggregateRange(int firstId, int lastId) const;
+
+	/*
+	*  @brief Builds a secondary index on the field; it is then kept up to date by every change
+	*/
+	void enableIndex(AccountField field);
+
+	void disableIndex(AccountField field);
+
+	bool hasIndex(AccountField field) const { return indexes.isEnabled(field); }
 
-	vector<Account> getAllAccounts();
+	/*
+	*  @brief Accounts whose field lies in [lo, hi], ordered by the field and then by ID
+	*  @note O(log n + k) index lookup when the field is indexed, a full scan otherwise
+	*/
+	vector<Account> findAccountsInRange(AccountField field, double lo, double hi) const;
+
+	/*
+	*  @brief Number of accounts whose field lies in [lo, hi], O(log n) when the field is indexed
+	*/
+	size_t countAccountsInRange(AccountField field, double lo, double hi) const;
 
-	SplayTree<Account> getDemoAccounts();
+	/*
+	*  @brief Counts the accounts matching the filter and sums their balances, over the columnar copy
+	*  @note Vectorized (SSE2/AVX2 when available) and multithreaded for large stores
+	*  @note The first call builds the columnar copy in O(n); it is kept up to date from then on
+	*/
+	ColumnScan scanAccounts(const ColumnFilter& filter) const;
+
+	AccountTree getDemoAccounts();
+
+	/*
+	*  @brief The demo accounts in the order getDemoAccounts inserts them, for trees of other types
+	*/
+	static vector<Account> getDemoAccountList();
 	void getAccountsFromCsv();
 
-	SplayTree<Account>* readAccountsFromCsv(const QString& filePath);
+	AccountBook* readAccountsFromCsv(const QString& filePath);
+
+	/*
+	*  @brief Writes every account, in ID order, to a binary snapshot (see AccountSnapshot)
+	*  @return false if the file could not be written
+	*/
+	bool saveSnapshot(const QString& filePath);
+
+	/*
+	*  @brief Replaces the accounts with the contents of a binary snapshot
+	*  @return false if the snapshot is missing or invalid; the accounts are then unchanged
+	*/
+	bool loadSnapshot(const QString& filePath);
+
+	/*
+	*  @brief Compacts the journal: saves a full snapshot, then empties the journal
+	*  @return false if the snapshot could not be written; the journal is then kept
+	*/
+	bool checkpoint();
+
+	/*
+	*  @brief Copies the accounts into a sharded, thread-safe store for multi-threaded request handlers
+	*  @param shardCount number of shards, 0 picks twice the hardware thread count
+	*  @note The store allocates IDs above every ID handed out so far
+	*/
+	unique_ptr<AccountStore> makeShardedStore(size_t shardCount = 0) const;
+
+	/*
+	*  @brief O(1) point-in-time view of all accounts
+	*  @note The view stays frozen while accounts keep changing and may be read from another thread
+	*  @note The first call builds the versioned copy in O(n); it is kept up to date from then on
+	*/
+	AccountVersion snapshotAccounts() const;
+
+	bool isEmpty() const;
+
+	/*
+	*  @brief Comparisons, rotations by kind, lookup hits and misses and access depths of the account tree
+	*         since startup or the last resetTreeStats(), with its live node count and node memory
+	*  @note The counters stay zero unless built with ACCOUNT_TREE_STATS (see AccountBookTraits)
+	*/
+	SplayStats treeStats() const { return accounts->stats(); }
+
+	void resetTreeStats() { accounts->resetStats(); }
+
+	/*
+	*  @brief Number of levels of the account tree, computed without recursion
+	*/
+	int treeHeight() const { return accounts->height(); }
+
+	/*
+	*  @brief Depth histogram of about sampleCount accounts spread evenly over the ID order
+	*  @return Element d counts the sampled accounts at depth d, the root being depth 0
+	*/
+	vector<size_t> treeDepthProfile(size_t sampleCount = 1024) const;
 
-	bool isEmpty();
+	/*
+	*  @brief treeStats, treeHeight and treeDepthProfile as "metric,value" CSV lines, for monitoring exports
+	*/
+	QString exportTreeStats() const;
 
 private:
-	SplayTree<Account>* accounts = new SplayTree<Account>;
+	AccountBook* accounts = new AccountBook;
+	AccountJournal* journal; ///< Write-ahead log of every mutation since the last checkpoint
+	mutable PersistentTree<Account, AccountTraits> versions; ///< Versioned copy of the accounts backing snapshotAccounts()
+	mutable bool versionsBuilt = false; ///< Whether versions exists yet; until the first snapshot it is not kept
+	AccountIndexes indexes; ///< Secondary indexes turned on with enableIndex()
+	mutable AccountColumns columns; ///< Column-per-field copy of the accounts for scanAccounts()
+	mutable bool columnsBuilt = false; ///< Whether columns exists yet; until the first scan it is not kept
 	static int accountCount;
+	bool splayOnRead = true;
+
+	void replayJournal();
+	void rebuildViews();
+	void upsertViews(const Account& acc);
+	void eraseFromViews(int id);
 	 
 };
 
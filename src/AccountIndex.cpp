@@ -0,0 +1,112 @@
+#include "AccountIndex.h"
+#include <climits>
+
+double AccountIndexes::fieldValue(const Account& account, AccountField field)
+{
+	switch (field) {
+	case AccountField::CreditScore: return account.getCreditScore();
+	case AccountField::Balance:     return account.getBalance();
+	case AccountField::Age:         return account.getAge();
+	case AccountField::Tenure:      return account.getTenure();
+	}
+	return 0.0;
+}
+
+unique_ptr<AccountIndexes::IndexTree> AccountIndexes::build(AccountField field, const vector<Account>& accounts)
+{
+	vector<IndexEntry> entries;
+	entries.reserve(accounts.size());
+	for (const Account& account : accounts)
+		entries.push_back(entry(account, field));
+
+	// buildFrom sorts the entries and links a balanced tree in one pass
+	unique_ptr<IndexTree> index(new IndexTree);
+	index->buildFrom(std::move(entries));
+	return index;
+}
+
+void AccountIndexes::enable(AccountField field, const vector<Account>& accounts)
+{
+	if (!indexes[slot(field)])
+		indexes[slot(field)] = build(field, accounts);
+}
+
+void AccountIndexes::disable(AccountField field)
+{
+	indexes[slot(field)].reset();
+}
+
+void AccountIndexes::rebuild(const vector<Account>& accounts)
+{
+	for (size_t i = 0; i < fieldCount; i++)
+		if (indexes[i])
+			indexes[i] = build(static_cast<AccountField>(i), accounts);
+}
+
+void AccountIndexes::insert(const Account& account)
+{
+	// emplace throws on allocation failure (insert would swallow it); undo the indexes already done
+	array<bool, fieldCount> added{};
+	try {
+		for (size_t i = 0; i < fieldCount; i++)
+			if (indexes[i])
+				added[i] = indexes[i]->emplace(entry(account, static_cast<AccountField>(i))).second;
+	}
+	catch (...) {
+		for (size_t i = 0; i < fieldCount; i++)
+			if (added[i])
+				indexes[i]->erase(entry(account, static_cast<AccountField>(i)));
+		throw;
+	}
+}
+
+void AccountIndexes::update(const Account& before, const Account& after)
+{
+	// Add every new entry before removing any old one, so undoing a failed update only erases
+	array<bool, fieldCount> added{}, moved{};
+	try {
+		for (size_t i = 0; i < fieldCount; i++) {
+			if (!indexes[i])
+				continue;
+
+			AccountField field = static_cast<AccountField>(i);
+			IndexEntry oldEntry = entry(before, field);
+			IndexEntry newEntry = entry(after, field);
+			if (oldEntry.value == newEntry.value && oldEntry.id == newEntry.id)
+				continue;
+			added[i] = indexes[i]->emplace(newEntry).second;
+			moved[i] = true;
+		}
+	}
+	catch (...) {
+		for (size_t i = 0; i < fieldCount; i++)
+			if (added[i])
+				indexes[i]->erase(entry(after, static_cast<AccountField>(i)));
+		throw;
+	}
+
+	for (size_t i = 0; i < fieldCount; i++)
+		if (moved[i])
+			indexes[i]->erase(entry(before, static_cast<AccountField>(i)));
+}
+
+void AccountIndexes::erase(const Account& account)
+{
+	for (size_t i = 0; i < fieldCount; i++)
+		if (indexes[i])
+			indexes[i]->erase(entry(account, static_cast<AccountField>(i)));
+}
+
+vector<int> AccountIndexes::idsInRange(AccountField field, double lo, double hi) const
+{
+	vector<int> ids;
+	const IndexTree& index = *indexes[slot(field)];
+	for (auto it = index.lower_bound(IndexEntry{ lo, INT_MIN }); it != index.end() && it->value <= hi; ++it)
+		ids.push_back(it->id);
+	return ids;
+}
+
+size_t AccountIndexes::countInRange(AccountField field, double lo, double hi) const
+{
+	return indexes[slot(field)]->countInRange(IndexEntry{ lo, INT_MIN }, IndexEntry{ hi, INT_MAX });
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "Account.h"
+#include "SplayTree.h"
+#include <array>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Account fields that can carry a secondary index.
+ */
+enum class AccountField
+{
+	CreditScore,
+	Balance,
+	Age,
+	Tenure
+};
+
+/**
+ * @brief One secondary index entry: the indexed field value and the account it belongs to.
+ *        Entries are ordered by value, then by ID, so equal values stay distinct.
+ */
+struct IndexEntry
+{
+	double value;
+	int id;
+
+	bool operator<(const IndexEntry& other) const
+	{
+		return value < other.value || (value == other.value && id < other.id);
+	}
+};
+
+/**
+ * @brief Optional ordered secondary indexes over account fields.
+ *
+ * Each enabled field is a splay tree of (value, ID) entries with subtree sizes, so a range of
+ * values is found in O(log n) and its k IDs are listed in O(k), and counted in O(log n)
+ * without listing them. The owner reports every change to an account through insert, update
+ * and erase; disabled fields cost nothing.
+ */
+class AccountIndexes
+{
+public:
+	static constexpr size_t fieldCount = 4;
+
+	/**
+	 * @brief The value of the field in an account, as the index orders it.
+	 */
+	static double fieldValue(const Account& account, AccountField field);
+
+	/**
+	 * @brief Builds the index of a field from all accounts; a no-op if it already exists.
+	 */
+	void enable(AccountField field, const vector<Account>& accounts);
+
+	void disable(AccountField field);
+
+	bool isEnabled(AccountField field) const { return indexes[slot(field)] != nullptr; }
+
+	bool anyEnabled() const
+	{
+		for (const auto& index : indexes)
+			if (index)
+				return true;
+		return false;
+	}
+
+	/**
+	 * @brief Rebuilds every enabled index after the accounts were replaced in bulk.
+	 */
+	void rebuild(const vector<Account>& accounts);
+
+	/**
+	 * @brief Adds the entries of a new account.
+	 * @throws std::bad_alloc; the indexes are then unchanged.
+	 */
+	void insert(const Account& account);
+
+	/**
+	 * @brief Moves the entries of an account whose indexed fields may have changed.
+	 * @throws std::bad_alloc; the indexes are then unchanged.
+	 */
+	void update(const Account& before, const Account& after);
+
+	void erase(const Account& account);
+
+	/**
+	 * @brief IDs of the accounts whose field lies in [lo, hi], by ascending field value.
+	 * @warning The field must be enabled.
+	 */
+	vector<int> idsInRange(AccountField field, double lo, double hi) const;
+
+	/**
+	 * @brief Number of accounts whose field lies in [lo, hi], in O(log n).
+	 * @warning The field must be enabled.
+	 */
+	size_t countInRange(AccountField field, double lo, double hi) const;
+
+private:
+	using IndexTree = PooledSplayTree<IndexEntry, OrderStatisticsTraits<SplayTraits<IndexEntry>>>;
+
+	static size_t slot(AccountField field) { return static_cast<size_t>(field); }
+	static IndexEntry entry(const Account& account, AccountField field) { return { fieldValue(account, field), account.getCustomerID() }; }
+	static unique_ptr<IndexTree> build(AccountField field, const vector<Account>& accounts);
+
+	array<unique_ptr<IndexTree>, fieldCount> indexes;
+};
@@ -0,0 +1,356 @@
+#include "AccountJournal.h"
+#include "AccountSnapshot.h"
+#include <QFile>
+#include <QtEndian>
+#include <QDebug>
+#include <chrono>
+#include <cstring>
+#include <cstddef>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char journalMagic[8] = { 'B', 'S', 'T', 'J', 'R', 'N', 'L', '\0' };
+	const uint32_t journalVersion = 1;
+
+#pragma pack(push, 1)
+	struct JournalHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t recordSize;
+	};
+
+	struct JournalRecord
+	{
+		uint8_t op;
+		uint8_t active;
+		int16_t age;
+		int16_t tenure;
+		int16_t pad;
+		int32_t id;
+		int32_t creditScore;
+		double balance;
+		uint32_t checksum; ///< Low 32 bits of the Fletcher-64 of the preceding bytes.
+		uint32_t pad2;
+	};
+#pragma pack(pop)
+
+	static_assert(sizeof(JournalHeader) == 16, "Journal header layout changed");
+	static_assert(sizeof(JournalRecord) == 32, "Journal record layout changed");
+
+	const size_t checkedBytes = offsetof(JournalRecord, checksum);
+
+	inline double swapDouble(double value)
+	{
+		quint64 bits;
+		memcpy(&bits, &value, sizeof bits);
+		bits = qToLittleEndian(bits);
+		memcpy(&value, &bits, sizeof bits);
+		return value;
+	}
+
+	FILE* openForAppend(const QString& path)
+	{
+#ifdef _WIN32
+		return _wfopen(reinterpret_cast<const wchar_t*>(path.utf16()), L"ab");
+#else
+		return fopen(QFile::encodeName(path).constData(), "ab");
+#endif
+	}
+
+	bool syncToDisk(FILE* file)
+	{
+		if (fflush(file) != 0)
+			return false;
+#ifdef _WIN32
+		return _commit(_fileno(file)) == 0;
+#else
+		return fsync(fileno(file)) == 0;
+#endif
+	}
+}
+
+AccountJournal::AccountJournal(const QString& filePath, JournalOptions options)
+	: path(filePath), options(options)
+{
+	if (this->options.groupCommitOps == 0)
+		this->options.groupCommitOps = 1;
+}
+
+AccountJournal::~AccountJournal()
+{
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_all();
+	if (flusher.joinable())
+		flusher.join();
+
+	if (file) {
+		lock_guard<mutex> io(ioLock);
+		commitPending();
+		fclose(file);
+	}
+}
+
+size_t AccountJournal::replay(const function<void(Op, const Account&)>& apply)
+{
+	QFile in(path);
+	if (!in.open(QIODevice::ReadWrite))
+		return 0; // No journal yet
+
+	const QByteArray bytes = in.readAll();
+	const size_t size = static_cast<size_t>(bytes.size());
+	JournalHeader header;
+	if (size < sizeof header) {
+		in.resize(0); // Empty or torn header, open() writes a fresh one
+		return 0;
+	}
+	memcpy(&header, bytes.constData(), sizeof header);
+	if (memcmp(header.magic, journalMagic, sizeof header.magic) != 0
+		|| qFromLittleEndian(header.version) != journalVersion
+		|| qFromLittleEndian(header.recordSize) != sizeof(JournalRecord)) {
+		qCritical() << "Journal is of another format, not replaying it:" << path;
+		damaged = true;
+		return 0;
+	}
+
+	// Zeroed pages pass the checksum, so a record also needs a known operation
+	JournalRecord record;
+	auto intactAt = [&bytes, &record](size_t offset) {
+		memcpy(&record, bytes.constData() + offset, sizeof record);
+		uint32_t expected = static_cast<uint32_t>(AccountSnapshot::checksum(reinterpret_cast<const char*>(&record), checkedBytes));
+		return qFromLittleEndian(record.checksum) == expected
+			&& (record.op == static_cast<uint8_t>(Op::Upsert) || record.op == static_cast<uint8_t>(Op::Erase));
+	};
+
+	// Check every record before applying any. A crash during a group commit can tear any part
+	// of the last batch, so bad records are only damage when an intact one follows them
+	const size_t first = sizeof header;
+	size_t end = first;
+	while (end + sizeof record <= size && intactAt(end))
+		end += sizeof record;
+	for (size_t offset = end + sizeof record; offset + sizeof record <= size; offset += sizeof record) {
+		if (intactAt(offset)) {
+			qCritical() << "Journal is damaged at byte" << end << "of" << size << ", not replaying it:" << path;
+			damaged = true;
+			return 0;
+		}
+	}
+
+	size_t replayed = 0;
+	for (size_t offset = first; offset < end; offset += sizeof record) {
+		memcpy(&record, bytes.constData() + offset, sizeof record);
+		Account account(qFromLittleEndian(record.id), qFromLittleEndian(record.creditScore),
+			qFromLittleEndian(record.age), qFromLittleEndian(record.tenure),
+			swapDouble(record.balance), record.active != 0);
+		apply(static_cast<Op>(record.op), account);
+		replayed++;
+	}
+
+	if (end != size) {
+		qWarning() << "Journal has a torn tail, dropping" << size - end << "bytes";
+		in.resize(end);
+	}
+	return replayed;
+}
+
+bool AccountJournal::open()
+{
+	if (file)
+		return true;
+	if (damaged && !moveAside())
+		return false;
+
+	file = openForAppend(path);
+	if (!file) {
+		qWarning() << "Could not open journal:" << path;
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	if (ftell(file) == 0) {
+		JournalHeader header;
+		memcpy(header.magic, journalMagic, sizeof header.magic);
+		header.version = qToLittleEndian(journalVersion);
+		header.recordSize = qToLittleEndian<quint32>(sizeof(JournalRecord));
+		if (fwrite(&header, sizeof header, 1, file) != 1 || !syncToDisk(file)) {
+			qWarning() << "Could not initialize journal:" << path;
+			fclose(file);
+			file = nullptr;
+			return false;
+		}
+	}
+	committedBytes = ftell(file);
+	updateAvailable();
+
+	stopping = false;
+	flusher = thread(&AccountJournal::flusherLoop, this);
+	return true;
+}
+
+void AccountJournal::append(Op op, const Account& account)
+{
+	JournalRecord record;
+	memset(&record, 0, sizeof record);
+	record.op = static_cast<uint8_t>(op);
+	record.active = account.isActive() ? 1 : 0;
+	record.age = qToLittleEndian<qint16>(account.getAge());
+	record.tenure = qToLittleEndian<qint16>(account.getTenure());
+	record.id = qToLittleEndian<qint32>(account.getCustomerID());
+	record.creditScore = qToLittleEndian<qint32>(account.getCreditScore());
+	record.balance = swapDouble(account.getBalance());
+	record.checksum = qToLittleEndian(static_cast<uint32_t>(AccountSnapshot::checksum(reinterpret_cast<const char*>(&record), checkedBytes)));
+
+	lock_guard<mutex> guard(lock);
+	if (!available)
+		return; // Nothing could ever write it; buffering would only grow without bound
+	const char* bytes = reinterpret_cast<const char*>(&record);
+	pending.insert(pending.end(), bytes, bytes + sizeof record);
+	if (++pendingCount == 1 || pendingCount == options.groupCommitOps)
+		wake.notify_one(); // Start the group-commit timer, or hand the full batch to the flusher
+}
+
+bool AccountJournal::sync()
+{
+	// Waits for a commit the flusher has in progress, then commits what is left
+	lock_guard<mutex> io(ioLock);
+	return commitPending();
+}
+
+bool AccountJournal::reset()
+{
+	lock_guard<mutex> io(ioLock);
+	if (!commitPending())
+		return false;
+	if (file)
+		fclose(file);
+
+	QFile out(path);
+	if (!out.open(QIODevice::ReadWrite) || !out.resize(sizeof(JournalHeader))) {
+		qWarning() << "Could not truncate journal:" << path;
+		file = openForAppend(path);
+		updateAvailable();
+		return false;
+	}
+	out.close();
+
+	file = openForAppend(path);
+	updateAvailable();
+	committedBytes = sizeof(JournalHeader);
+	return file != nullptr && syncToDisk(file);
+}
+
+void AccountJournal::updateAvailable()
+{
+	lock_guard<mutex> guard(lock);
+	available = file != nullptr;
+	if (!available && pendingCount > 0) {
+		qCritical() << "Journal unavailable, dropping" << pendingCount << "unwritten records:" << path;
+		pending.clear();
+		pendingCount = 0;
+	}
+}
+
+bool AccountJournal::moveAside()
+{
+	QString aside = path + ".damaged";
+	for (int n = 1; QFile::exists(aside); n++)
+		aside = QString("%1.damaged.%2").arg(path).arg(n);
+	if (!QFile::rename(path, aside)) {
+		qCritical() << "Could not move the damaged journal aside, not journaling:" << path;
+		return false;
+	}
+	qCritical() << "Moved the damaged journal to" << aside << "- its changes were not applied";
+	damaged = false;
+	return true;
+}
+
+bool AccountJournal::isAvailable() const
+{
+	lock_guard<mutex> guard(lock);
+	return available;
+}
+
+size_t AccountJournal::pendingOps() const
+{
+	lock_guard<mutex> guard(lock);
+	return pendingCount + writingCount;
+}
+
+size_t AccountJournal::syncCount() const
+{
+	lock_guard<mutex> guard(lock);
+	return syncs;
+}
+
+bool AccountJournal::commitPending()
+{
+	{
+		// Take the whole batch; appenders fill a fresh buffer while it is written
+		lock_guard<mutex> guard(lock);
+		if (pendingCount == 0)
+			return true;
+		if (!file)
+			return false;
+		writing.swap(pending);
+		writingCount = pendingCount;
+		pendingCount = 0;
+	}
+
+	bool ok = fwrite(writing.data(), 1, writing.size(), file) == writing.size() && syncToDisk(file);
+	if (!ok) {
+		// Cut off whatever part made it, so a retry does not leave a bad record mid-file
+		fclose(file);
+		QFile::resize(path, committedBytes);
+		file = openForAppend(path);
+	}
+
+	{
+		lock_guard<mutex> guard(lock);
+		if (!ok) {
+			qWarning() << "Journal write failed, keeping" << writingCount << "records pending:" << path;
+			writing.insert(writing.end(), pending.begin(), pending.end());
+			writing.swap(pending);
+			pendingCount += writingCount;
+		}
+		else {
+			committedBytes += static_cast<qint64>(writing.size());
+			syncs++;
+		}
+		writing.clear();
+		writingCount = 0;
+	}
+
+	if (!ok)
+		updateAvailable(); // The reopen may have failed
+	return ok;
+}
+
+void AccountJournal::flusherLoop()
+{
+	unique_lock<mutex> guard(lock);
+	while (!stopping) {
+		wake.wait(guard, [this]() { return stopping || pendingCount > 0; });
+		if (stopping)
+			break;
+
+		// Give the batch groupCommitMs to fill up; append() wakes us early when it is full
+		wake.wait_for(guard, chrono::milliseconds(options.groupCommitMs),
+			[this]() { return stopping || pendingCount == 0 || pendingCount >= options.groupCommitOps; });
+
+		// Write without holding lock, so appends go on meanwhile
+		guard.unlock();
+		{
+			lock_guard<mutex> io(ioLock);
+			commitPending();
+		}
+		guard.lock();
+	}
+}
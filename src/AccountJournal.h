@@ -0,0 +1,126 @@
+#pragma once
+#include "Account.h"
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <QString>
+
+using namespace std;
+
+/**
+ * @brief When buffered journal records are forced to disk.
+ *
+ * The flusher thread writes and syncs a batch as soon as groupCommitOps records are pending,
+ * or at the latest groupCommitMs milliseconds after the first of them was appended.
+ * groupCommitOps = 1 commits every operation on its own; sync() waits until it is on disk.
+ */
+struct JournalOptions
+{
+	size_t groupCommitOps = 512;
+	int groupCommitMs = 20;
+};
+
+/**
+ * @brief Append-only write-ahead journal of account mutations with group commit.
+ *
+ * Each record holds the operation and the full account image (fixed 32 bytes with its own
+ * checksum), so replaying a record twice is harmless and a checkpoint only has to
+ * snapshot the tree and reset the journal. A torn tail (crash during a group commit) is cut
+ * off; a bad record followed by intact ones, or a header of another format, marks the journal damaged.
+ *
+ * append() never touches the disk: the flusher takes the whole batch and writes it without
+ * holding the lock appenders wait for.
+ */
+class AccountJournal
+{
+public:
+	enum class Op : uint8_t
+	{
+		Upsert = 1, ///< Insert or overwrite the account with this ID.
+		Erase = 2   ///< Remove the account with this ID.
+	};
+
+	explicit AccountJournal(const QString& filePath, JournalOptions options = JournalOptions());
+
+	/**
+	 * @brief Destructor. Syncs pending records and stops the background flusher.
+	 */
+	~AccountJournal();
+
+	AccountJournal(const AccountJournal&) = delete;
+	AccountJournal& operator=(const AccountJournal&) = delete;
+
+	/**
+	 * @brief Applies every record in file order, after checking them all. Must be called before open().
+	 * @param apply Receives each operation and account image.
+	 * @return Number of records replayed; 0 if the journal is damaged (see isDamaged), as then none are applied.
+	 */
+	size_t replay(const function<void(Op, const Account&)>& apply);
+
+	/**
+	 * @brief True if replay() found a header of another format or a bad record followed by intact ones.
+	 */
+	bool isDamaged() const { return damaged; }
+
+	/**
+	 * @brief Opens the journal for appending and starts the group-commit flusher.
+	 *        A damaged journal is first renamed to "<path>.damaged" (numbered if taken), then a new one is started.
+	 * @return False if the file cannot be opened or a damaged one cannot be moved aside.
+	 */
+	bool open();
+
+	/**
+	 * @brief Buffers a record; it becomes durable with the next group commit. Never waits for the disk.
+	 *        Dropped while the journal is unavailable (see isAvailable).
+	 */
+	void append(Op op, const Account& account);
+
+	/**
+	 * @brief True while the journal file is open. It is not before open() succeeds, nor after the
+	 *        file failed and could not be reopened; the records pending then are dropped.
+	 */
+	bool isAvailable() const;
+
+	/**
+	 * @brief Writes and syncs every pending record now.
+	 * @return False on an I/O error.
+	 */
+	bool sync();
+
+	/**
+	 * @brief Syncs, then truncates the journal to an empty one. Call after a checkpoint snapshot was saved.
+	 */
+	bool reset();
+
+	size_t pendingOps() const;                       ///< Records appended but not yet synced.
+	size_t syncCount() const;                        ///< Group commits performed so far.
+
+private:
+	bool commitPending();  // Caller holds ioLock
+	void updateAvailable(); // Caller holds ioLock
+	bool moveAside();
+	void flusherLoop();
+
+	QString path;
+	JournalOptions options;
+	FILE* file = nullptr;
+	qint64 committedBytes = 0; ///< File size after the last good commit; a failed write is cut back to it
+	bool damaged = false;
+
+	mutex ioLock;              ///< Serializes the writes to file; taken before lock, never while holding it
+	vector<char> writing;      ///< The batch being written, guarded by ioLock
+
+	mutable mutex lock;
+	condition_variable wake;
+	vector<char> pending;
+	size_t pendingCount = 0;
+	size_t writingCount = 0;
+	size_t syncs = 0;
+	bool available = false;    ///< Mirrors file != nullptr for append(), which does not take ioLock
+	bool stopping = false;
+	thread flusher;
+};
@@ -0,0 +1,167 @@
+#include "AccountSnapshot.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+
+namespace
+{
+	const char snapshotMagic[8] = { 'B', 'S', 'T', 'S', 'N', 'A', 'P', '\0' };
+
+#pragma pack(push, 1)
+	struct SnapshotHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t recordSize;
+		uint64_t count;
+		uint64_t checksum;
+	};
+
+	struct SnapshotRecord
+	{
+		int32_t id;
+		int32_t creditScore;
+		int16_t age;
+		int16_t tenure;
+		uint8_t active;
+		uint8_t pad[3];
+		double balance;
+	};
+#pragma pack(pop)
+
+	static_assert(sizeof(SnapshotHeader) == 32, "Snapshot header layout changed");
+	static_assert(sizeof(SnapshotRecord) == 24, "Snapshot record layout changed");
+
+	inline double doubleFromLittleEndian(double value)
+	{
+		quint64 bits;
+		memcpy(&bits, &value, sizeof bits);
+		bits = qFromLittleEndian(bits);
+		memcpy(&value, &bits, sizeof bits);
+		return value;
+	}
+}
+
+uint64_t AccountSnapshot::checksum(const char* data, size_t bytes)
+{
+	const uint64_t modulus = 0xFFFFFFFFull;
+	uint64_t sum1 = 0, sum2 = 0;
+	size_t words = bytes / 4;
+
+	while (words)
+	{
+		// 64-bit sums cannot overflow within this many 32-bit words
+		size_t block = words < 65536 ? words : 65536;
+		words -= block;
+		for (; block; --block, data += 4)
+		{
+			uint32_t word;
+			memcpy(&word, data, 4);
+			sum1 += qFromLittleEndian(word);
+			sum2 += sum1;
+		}
+		sum1 %= modulus;
+		sum2 %= modulus;
+	}
+
+	if (bytes % 4)
+	{
+		uint32_t word = 0;
+		memcpy(&word, data, bytes % 4);
+		sum1 = (sum1 + qFromLittleEndian(word)) % modulus;
+		sum2 = (sum2 + sum1) % modulus;
+	}
+	return (sum2 << 32) | sum1;
+}
+
+bool AccountSnapshot::save(const QString& filePath, const vector<Account>& accounts)
+{
+	vector<SnapshotRecord> records(accounts.size());
+	for (size_t i = 0; i < accounts.size(); i++) {
+		const Account& account = accounts[i];
+		SnapshotRecord& record = records[i];
+		record.id = qToLittleEndian<qint32>(account.getCustomerID());
+		record.creditScore = qToLittleEndian<qint32>(account.getCreditScore());
+		record.age = qToLittleEndian<qint16>(account.getAge());
+		record.tenure = qToLittleEndian<qint16>(account.getTenure());
+		record.active = account.isActive() ? 1 : 0;
+		memset(record.pad, 0, sizeof record.pad);
+		record.balance = doubleFromLittleEndian(account.getBalance()); // Byte swap is symmetric
+	}
+
+	const char* payload = reinterpret_cast<const char*>(records.data());
+	const size_t payloadBytes = records.size() * sizeof(SnapshotRecord);
+
+	SnapshotHeader header;
+	memcpy(header.magic, snapshotMagic, sizeof header.magic);
+	header.version = qToLittleEndian(version);
+	header.recordSize = qToLittleEndian<quint32>(sizeof(SnapshotRecord));
+	header.count = qToLittleEndian<quint64>(records.size());
+	header.checksum = qToLittleEndian<quint64>(checksum(payload, payloadBytes));
+
+	QSaveFile file(filePath);
+	if (!file.open(QIODevice::WriteOnly)) {
+		qWarning() << "Could not create snapshot:" << filePath << file.errorString();
+		return false;
+	}
+	if (file.write(reinterpret_cast<const char*>(&header), sizeof header) != qint64(sizeof header)
+		|| file.write(payload, qint64(payloadBytes)) != qint64(payloadBytes)) {
+		qWarning() << "Could not write snapshot:" << filePath << file.errorString();
+		file.cancelWriting();
+		return false;
+	}
+	return file.commit();
+}
+
+bool AccountSnapshot::load(const QString& filePath, vector<Account>& accounts)
+{
+	QFile file(filePath);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	const qint64 size = file.size();
+	if (size < qint64(sizeof(SnapshotHeader))) {
+		qWarning() << "Snapshot too small:" << filePath;
+		return false;
+	}
+
+	const uchar* data = file.map(0, size);
+	if (!data) {
+		qWarning() << "Could not map snapshot:" << filePath << file.errorString();
+		return false;
+	}
+
+	SnapshotHeader header;
+	memcpy(&header, data, sizeof header);
+	const quint64 count = qFromLittleEndian(header.count);
+	const char* payload = reinterpret_cast<const char*>(data) + sizeof header;
+	const size_t payloadBytes = static_cast<size_t>(size) - sizeof header;
+
+	bool valid = memcmp(header.magic, snapshotMagic, sizeof header.magic) == 0
+		&& qFromLittleEndian(header.version) == version
+		&& qFromLittleEndian(header.recordSize) == sizeof(SnapshotRecord)
+		&& count == payloadBytes / sizeof(SnapshotRecord)
+		&& payloadBytes % sizeof(SnapshotRecord) == 0
+		&& checksum(payload, payloadBytes) == qFromLittleEndian(header.checksum);
+
+	if (!valid) {
+		qWarning() << "Snapshot is corrupt or of another version:" << filePath;
+		file.unmap(const_cast<uchar*>(data));
+		return false;
+	}
+
+	accounts.clear();
+	accounts.reserve(static_cast<size_t>(count));
+	SnapshotRecord record;
+	for (size_t i = 0; i < count; i++) {
+		memcpy(&record, payload + i * sizeof record, sizeof record);
+		accounts.emplace_back(qFromLittleEndian(record.id), qFromLittleEndian(record.creditScore),
+			qFromLittleEndian(record.age), qFromLittleEndian(record.tenure),
+			doubleFromLittleEndian(record.balance), record.active != 0);
+	}
+
+	file.unmap(const_cast<uchar*>(data));
+	return true;
+}
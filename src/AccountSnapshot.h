@@ -0,0 +1,42 @@
+#pragma once
+#include "Account.h"
+#include <vector>
+#include <cstdint>
+#include <QString>
+
+using namespace std;
+
+/**
+ * @brief Versioned, checksummed binary image of the account store.
+ *
+ * Layout (little-endian):
+ * @code
+ * Header  { char magic[8] = "BSTSNAP"; uint32 version; uint32 recordSize; uint64 count; uint64 checksum; }
+ * Records { int32 id; int32 creditScore; int16 age; int16 tenure; uint8 active; uint8 pad[3]; double balance; } x count
+ * @endcode
+ * Records are stored sorted by customer ID, so a loaded image can be handed to
+ * SplayTree::buildFrom without sorting. The checksum is Fletcher-64 over the record bytes.
+ */
+class AccountSnapshot
+{
+public:
+	static constexpr uint32_t version = 1;
+
+	/**
+	 * @brief Writes the accounts to filePath atomically (through a temporary file).
+	 * @param accounts Accounts sorted by customer ID.
+	 * @return False on any I/O error; an existing snapshot is then left untouched.
+	 */
+	static bool save(const QString& filePath, const vector<Account>& accounts);
+
+	/**
+	 * @brief Reads a snapshot, replacing the contents of accounts.
+	 * @return False if the file is missing, of another version, truncated or fails its checksum.
+	 */
+	static bool load(const QString& filePath, vector<Account>& accounts);
+
+	/**
+	 * @brief Fletcher-64 checksum over 32-bit words; a trailing partial word is zero-padded.
+	 */
+	static uint64_t checksum(const char* data, size_t bytes);
+};
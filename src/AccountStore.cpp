@@ -0,0 +1,163 @@
+#include "AccountStore.h"
+#include <thread>
+
+namespace
+{
+	atomic<uint64_t> nextStoreInstance{ 1 };
+
+	// IDs leased by this thread; only valid for the store that leased them
+	struct IdLease
+	{
+		uint64_t store = 0;
+		int next = 0;
+		int end = 0;
+	};
+	thread_local IdLease idLease;
+}
+
+AccountStore::AccountStore(size_t shardCount, int lastUsedId)
+	: nextIdBlock(lastUsedId + 1), instanceId(nextStoreInstance.fetch_add(1))
+{
+	if (shardCount == 0)
+		shardCount = 2 * max(1u, thread::hardware_concurrency());
+
+	shards.reserve(shardCount);
+	for (size_t i = 0; i < shardCount; i++)
+		shards.push_back(make_unique<Shard>());
+}
+
+int AccountStore::allocateId()
+{
+	if (idLease.store != instanceId || idLease.next == idLease.end) {
+		idLease.store = instanceId;
+		idLease.next = nextIdBlock.fetch_add(idBlockSize, memory_order_relaxed);
+		idLease.end = idLease.next + idBlockSize;
+	}
+	return idLease.next++;
+}
+
+bool AccountStore::insert(const Account& account)
+{
+	Shard& shard = shardFor(account.getCustomerID());
+	lock_guard<shared_mutex> guard(shard.lock);
+	return shard.tree.try_emplace(account.getCustomerID(), account).second;
+}
+
+int AccountStore::create(int creditScore, short age, short tenure, double balance, bool isActiveMember)
+{
+	// An ID inserted directly (load, insert) may already sit in our lease; skip past it
+	for (;;) {
+		int id = allocateId();
+		Shard& shard = shardFor(id);
+		lock_guard<shared_mutex> guard(shard.lock);
+		if (shard.tree.emplace(id, creditScore, age, tenure, balance, isActiveMember).second)
+			return id;
+	}
+}
+
+bool AccountStore::update(const Account& account)
+{
+	Shard& shard = shardFor(account.getCustomerID());
+	lock_guard<shared_mutex> guard(shard.lock);
+	AccountTree::NodeType* stored = shard.tree.find(account.getCustomerID());
+	if (!stored)
+		return false;
+	stored->data = account;
+	shard.tree.refreshAugments(stored);
+	return true;
+}
+
+bool AccountStore::erase(int id)
+{
+	Shard& shard = shardFor(id);
+	lock_guard<shared_mutex> guard(shard.lock);
+	return shard.tree.erase(id);
+}
+
+bool AccountStore::get(int id, Account& out)
+{
+	Shard& shard = shardFor(id);
+	lock_guard<shared_mutex> guard(shard.lock);
+	auto node = shard.tree.search(id);
+	if (!node)
+		return false;
+	out = node->data;
+	return true;
+}
+
+bool AccountStore::peek(int id, Account& out) const
+{
+	const Shard& shard = shardFor(id);
+	shared_lock<shared_mutex> guard(shard.lock);
+	const Account* stored = static_cast<const AccountTree&>(shard.tree).peek(id);
+	if (!stored)
+		return false;
+	out = *stored;
+	return true;
+}
+
+bool AccountStore::contains(int id) const
+{
+	const Shard& shard = shardFor(id);
+	shared_lock<shared_mutex> guard(shard.lock);
+	return shard.tree.contains(id);
+}
+
+size_t AccountStore::size() const
+{
+	size_t total = 0;
+	for (const unique_ptr<Shard>& shard : shards) {
+		shared_lock<shared_mutex> guard(shard->lock);
+		total += static_cast<size_t>(shard->tree.nodeCount());
+	}
+	return total;
+}
+
+void AccountStore::load(vector<Account> accounts)
+{
+	vector<vector<Account>> parts(shards.size());
+	int largestId = nextIdBlock.load() - 1;
+	for (Account& account : accounts) {
+		largestId = max(largestId, account.getCustomerID());
+		parts[shardIndex(account.getCustomerID())].push_back(std::move(account));
+	}
+
+	for (size_t i = 0; i < shards.size(); i++) {
+		lock_guard<shared_mutex> guard(shards[i]->lock);
+		shards[i]->tree.buildFrom(std::move(parts[i]));
+	}
+
+	// Make sure no future lease overlaps a loaded ID
+	int expected = nextIdBlock.load();
+	while (expected <= largestId && !nextIdBlock.compare_exchange_weak(expected, largestId + 1)) {}
+}
+
+bool AccountStore::refill(size_t shard, ScanCursor& cursor) const
+{
+	cursor.chunk.clear();
+	cursor.next = 0;
+	if (cursor.done)
+		return false;
+
+	shared_lock<shared_mutex> guard(shards[shard]->lock);
+	const AccountTree& tree = shards[shard]->tree;
+	// Resume above the last ID copied, wherever writers have moved things since
+	auto it = cursor.started ? tree.upper_bound(cursor.lastId) : tree.begin();
+	for (; it != tree.end() && cursor.chunk.size() < scanChunk; ++it)
+		cursor.chunk.push_back(*it);
+
+	cursor.started = true;
+	if (cursor.chunk.empty()) {
+		cursor.done = true;
+		return false;
+	}
+	cursor.lastId = cursor.chunk.back().getCustomerID();
+	return true;
+}
+
+vector<Account> AccountStore::getAllAccounts() const
+{
+	vector<Account> all;
+	forEachInOrder([&all](const Account& account) { all.push_back(account); });
+	return all;
+}
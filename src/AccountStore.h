@@ -0,0 +1,166 @@
+#pragma once
+#include "AccountTree.h"
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <memory>
+#include <cstdint>
+#include <queue>
+#include <functional>
+
+using namespace std;
+
+/**
+ * @brief Thread-safe account store split into independently locked SplayTree shards.
+ *
+ * An account lives in the shard picked by hashing its customer ID, so every single-account
+ * operation locks exactly one shard and threads working on different accounts rarely meet.
+ * Read-only lookups (peek, contains) share the shard lock; anything that changes or splays
+ * a shard takes it exclusively. Whole-store scans merge the in-order sequences of the shards,
+ * so callers still see accounts in ascending ID order.
+ *
+ * New IDs come from allocateId(): each thread leases a block of IDs from a shared atomic
+ * counter and hands them out locally, so allocation takes no lock and touches the shared
+ * counter once per block. IDs are unique and increasing per thread, not globally dense.
+ */
+class AccountStore
+{
+public:
+	/**
+	 * @param shardCount Number of shards, 0 picks twice the hardware thread count.
+	 * @param lastUsedId Largest ID already taken; allocateId() hands out larger ones.
+	 */
+	explicit AccountStore(size_t shardCount = 0, int lastUsedId = 0);
+
+	AccountStore(const AccountStore&) = delete;
+	AccountStore& operator=(const AccountStore&) = delete;
+
+	/**
+	 * @brief Returns a fresh customer ID without taking any lock.
+	 */
+	int allocateId();
+
+	/**
+	 * @brief Inserts the account unless its ID is taken.
+	 * @return True if inserted.
+	 */
+	bool insert(const Account& account);
+
+	/**
+	 * @brief Creates an account with a freshly allocated ID, skipping IDs that are already taken.
+	 * @return The new account's ID.
+	 */
+	int create(int creditScore, short age, short tenure, double balance, bool isActiveMember);
+
+	/**
+	 * @brief Overwrites the account with the same ID.
+	 * @return False if no such account exists.
+	 */
+	bool update(const Account& account);
+
+	/**
+	 * @brief Removes the account with the ID.
+	 * @return False if no such account exists.
+	 */
+	bool erase(int id);
+
+	/**
+	 * @brief Copies the account out, splaying it to the root of its shard.
+	 * @return False if no such account exists.
+	 */
+	bool get(int id, Account& out);
+
+	/**
+	 * @brief Copies the account out without restructuring its shard.
+	 */
+	bool peek(int id, Account& out) const;
+
+	bool contains(int id) const;
+
+	size_t size() const;
+
+	size_t shardCount() const { return shards.size(); }
+
+	/**
+	 * @brief Replaces the contents, spreading the accounts over the shards and bulk-building each.
+	 */
+	void load(vector<Account> accounts);
+
+	/**
+	 * @brief Calls visit(const Account&) for every account in ascending ID order.
+	 * @note Each shard is read in chunks of scanChunk accounts under its shared lock, so the scan
+	 *       holds no lock while visiting and copies at most one chunk per shard at a time. Writers
+	 *       may change a shard between its chunks: the result is consistent per chunk only.
+	 */
+	template <class Visit>
+	void forEachInOrder(Visit visit) const;
+
+	/**
+	 * @brief All accounts in ascending ID order.
+	 */
+	vector<Account> getAllAccounts() const;
+
+private:
+	static_assert(!AccountTraits::collectStats, "Lookups under a shared lock must not write operation counters");
+
+	struct alignas(64) Shard
+	{
+		mutable shared_mutex lock;
+		AccountTree tree;
+	};
+
+	/**
+	 * @brief A shard's place in a scan: the chunk being visited and where the next one starts.
+	 */
+	struct ScanCursor
+	{
+		vector<Account> chunk;
+		size_t next = 0;      ///< Next account of chunk to visit.
+		int lastId = 0;       ///< Largest ID copied so far; the next chunk starts above it.
+		bool started = false;
+		bool done = false;
+	};
+
+	Shard& shardFor(int id) const { return *shards[shardIndex(id)]; }
+	size_t shardIndex(int id) const
+	{
+		// Fibonacci hashing spreads sequential IDs evenly; multiply-shift maps the hash onto the shards
+		uint64_t hash = static_cast<uint32_t>(static_cast<uint32_t>(id) * 2654435769u);
+		return static_cast<size_t>((hash * shards.size()) >> 32);
+	}
+
+	/**
+	 * @brief Copies the shard's next chunk into the cursor under a shared lock.
+	 * @return False once the shard has nothing left.
+	 */
+	bool refill(size_t shard, ScanCursor& cursor) const;
+
+	static constexpr int idBlockSize = 256;
+	static constexpr size_t scanChunk = 1024;
+
+	vector<unique_ptr<Shard>> shards;
+	atomic<int> nextIdBlock;   ///< First ID of the next unleased block.
+	const uint64_t instanceId; ///< Tells apart the stores a thread leases IDs from.
+};
+
+template <class Visit>
+void AccountStore::forEachInOrder(Visit visit) const
+{
+	// k-way merge of the shards' in-order chunks through a min-heap of (next ID, shard)
+	using Head = pair<int, size_t>;
+	priority_queue<Head, vector<Head>, greater<Head>> heads;
+	vector<ScanCursor> cursors(shards.size());
+	for (size_t i = 0; i < shards.size(); i++)
+		if (refill(i, cursors[i]))
+			heads.emplace(cursors[i].chunk[0].getCustomerID(), i);
+
+	while (!heads.empty()) {
+		size_t shard = heads.top().second;
+		heads.pop();
+		ScanCursor& cursor = cursors[shard];
+		visit(cursor.chunk[cursor.next++]);
+		if (cursor.next < cursor.chunk.size() || refill(shard, cursor))
+			heads.emplace(cursor.chunk[cursor.next].getCustomerID(), shard);
+	}
+}
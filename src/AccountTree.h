@@ -0,0 +1,81 @@
+#pragma once
+#include "Account.h"
+#include "SplayTree.h"
+#include "PersistentTree.h"
+#include <climits>
+
+/**
+ * @brief Totals over a set of accounts, kept for every subtree of an AccountTree.
+ *        Default-constructed it describes no accounts.
+ */
+struct AccountSummary
+{
+	size_t accounts = 0;
+	size_t activeMembers = 0;
+	double totalBalance = 0.0;
+	int minCreditScore = INT_MAX;
+	int maxCreditScore = INT_MIN;
+};
+
+/**
+ * @brief Orders accounts by customer ID, so an account tree is a map from ID to Account
+ *        and can be searched with a plain int. Subtree sizes are kept so the account list
+ *        can be paged (select) and ID ranges counted (countInRange) without a full scan.
+ *        An AccountSummary per subtree answers branch totals over ID ranges (aggregateRange).
+ *        Operation counters are off, so concurrent readers stay safe (see AccountBookTraits).
+ */
+struct AccountTraits : SplayTraits<Account>
+{
+	using key_type = int;
+
+	static constexpr bool orderStatistics = true;
+
+	using aggregate_type = AccountSummary;
+
+	static key_type keyOf(const Account& account) { return account.getCustomerID(); }
+
+	static AccountSummary measure(const Account& account)
+	{
+		AccountSummary one;
+		one.accounts = 1;
+		one.activeMembers = account.isActive() ? 1 : 0;
+		one.totalBalance = account.getBalance();
+		one.minCreditScore = one.maxCreditScore = account.getCreditScore();
+		return one;
+	}
+
+	static AccountSummary combine(const AccountSummary& a, const AccountSummary& b)
+	{
+		AccountSummary sum;
+		sum.accounts = a.accounts + b.accounts;
+		sum.activeMembers = a.activeMembers + b.activeMembers;
+		sum.totalBalance = a.totalBalance + b.totalBalance;
+		sum.minCreditScore = a.minCreditScore < b.minCreditScore ? a.minCreditScore : b.minCreditScore;
+		sum.maxCreditScore = a.maxCreditScore > b.maxCreditScore ? a.maxCreditScore : b.maxCreditScore;
+		return sum;
+	}
+};
+
+/**
+ * @brief Tree type backing the account store. Nodes come from a slab arena so loading
+ *        a CSV costs one allocation per block instead of one per account.
+ */
+using AccountTree = PooledSplayTree<Account, AccountTraits>;
+
+/**
+ * @brief Traits of AccountDAL's own tree. Building with ACCOUNT_TREE_STATS defined turns the
+ *        operation counters on for AccountDAL::treeStats(); the sharded AccountStore never counts,
+ *        as its lookups run concurrently.
+ */
+#if defined(ACCOUNT_TREE_STATS)
+using AccountBookTraits = StatsTraits<AccountTraits>;
+#else
+using AccountBookTraits = AccountTraits;
+#endif
+
+using AccountBook = PooledSplayTree<Account, AccountBookTraits>;
+
+/**
+ * @brief Frozen point-in-time view of all accounts (see PersistentTree), for reports and exports.
+ */
+using AccountVersion = PersistentTree<Account, AccountTraits>::Version;
@@ -164,6 +164,8 @@ void BankSplayTree::openSplayDemo() {
 
 
 BankSplayTree::~BankSplayTree()
-{}
+{
+    delete accountDAL; // Flushes the account journal
+}
 
 
@@ -0,0 +1,1227 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include "SplayTree.h"
+using namespace std;
+
+/**
+ * @brief A splay tree stored in two parallel arrays and linked by 32-bit indices.
+ *
+ * SplayTree allocates every node on its own and links them with 64-bit pointers. This engine
+ * keeps node i in slot i of two arrays instead:
+ * - hot[i]: the key and the child and parent indices, everything a descent and the splay after
+ *   it touch (16 bytes for an int key, so four nodes share a cache line and none straddles two),
+ * - payload[i]: the value itself, only touched once a lookup has found its node.
+ * A descent therefore walks one small array and there is no per-node allocation overhead. buildFrom() lays the nodes out breadth-first, so the top levels
+ * of a freshly loaded tree sit next to each other. erase() moves the last node into the freed
+ * slot, so the arrays stay dense.
+ *
+ * The public interface follows SplayTree (insert, emplace, search, find, peek, erase, iterators,
+ * lower_bound, buildFrom, mergeFrom, display, height, depthProfile, stats) and both SplayModes are
+ * supported. Values are reached through T* instead of Node*, as there are no node objects.
+ * Not supported: subtree augments (orderStatistics, aggregate_type), rotation observers,
+ * split/join and the parallel visitors; use SplayTree for those.
+ *
+ * @warning Like for a vector, inserting may move every value and erasing moves one, so pointers
+ *          and iterators are invalidated by any insert or erase. Values must not be modified in a
+ *          way that changes their key, which is stored a second time in hot.
+ * @tparam T The data type stored in the tree.
+ * @tparam Traits Key extraction, comparison and mode, as for SplayTree (see SplayTraits).
+ */
+template <class T, class Traits = SplayTraits<T>>
+class CompactSplayTree
+{
+private:
+    using index_type = uint32_t;
+
+    static constexpr index_type nil = numeric_limits<index_type>::max(); ///< The null link.
+
+    struct HotNode;
+
+public:
+    using key_type = typename Traits::key_type;
+
+    static_assert(!Traits::orderStatistics && is_void<typename Traits::aggregate_type>::value,
+                  "CompactSplayTree keeps no subtree sizes or aggregates; use SplayTree with these traits");
+    static_assert(!Traits::template observer<HotNode>::enabled,
+                  "CompactSplayTree reports no rotations; use SplayTree with an observer");
+
+    static constexpr size_t maxSize = nil; ///< Indices are 32 bits wide and one value is the null link.
+
+    CompactSplayTree() = default;
+    CompactSplayTree(const CompactSplayTree&) = default;
+    CompactSplayTree(CompactSplayTree&& other) noexcept { swap(other); }
+    CompactSplayTree& operator=(const CompactSplayTree&) = default;
+    CompactSplayTree& operator=(CompactSplayTree&& other) noexcept { swap(other); return *this; }
+
+    void swap(CompactSplayTree& other) noexcept;
+
+    /**
+     * @brief Removes every value; the arrays keep their capacity.
+     */
+    void clear();
+
+    /**
+     * @brief Makes room for count values, so loading them moves nothing.
+     * @throws std::length_error if count exceeds maxSize
+     */
+    void reserve(size_t count);
+
+    /**
+     * @brief Returns the spare capacity left behind by growth or erase.
+     */
+    void shrink_to_fit();
+
+    /*
+     * @brief Displays the tree content using inorder traversal by default.
+     * @param displayMode 1 prints preorder, anything else inorder.
+     */
+    void display(ostream& out = cout, int displayMode = 0) const;
+
+    /*
+     * @brief Inserts a value and splays it to the root. Duplicate keys are ignored.
+     * @throws std::bad_alloc, std::length_error; the tree is then unchanged
+     */
+    void insert(const T& value);
+    void insert(T&& value);
+
+    /**
+     * @brief Constructs a value and inserts it unless its key is present.
+     * @return The value now at the root and whether it was inserted.
+     * @throws std::bad_alloc, std::length_error; the tree is then unchanged
+     */
+    template <class... Args>
+    pair<T*, bool> emplace(Args&&... args);
+
+    /**
+     * @brief Constructs a value from args only if key is absent.
+     * @param key Must equal the key of the value args construct.
+     */
+    template <class... Args>
+    pair<T*, bool> try_emplace(const key_type& key, Args&&... args);
+
+    /**
+     * @brief Inserts the value, or overwrites the stored value with the same key.
+     * @return The value now at the root and true if inserted, false if assigned.
+     */
+    template <class V>
+    pair<T*, bool> insert_or_assign(V&& value);
+
+    /**
+     * @brief Replaces the contents with a range of values, in any order; the first of equal keys is kept.
+     * @details Links a perfectly balanced tree laid out breadth-first, without splaying.
+     * @throws std::bad_alloc, std::length_error; the tree is then unchanged
+     */
+    template <class Range>
+    void buildFrom(Range&& values);
+
+    /**
+     * @brief Adds a batch of values; existing keys win.
+     * @details Small batches are inserted one by one, larger ones are merged with the contents and
+     *          the whole tree is rebuilt balanced in O(n + m), as in SplayTree::mergeFrom.
+     */
+    template <class Range>
+    void mergeFrom(Range&& values);
+
+    /**
+     * @brief Removes the value with the key; the last node moves into its slot.
+     * @return True if the key was found.
+     */
+    bool erase(const key_type& key);
+
+    bool empty() const { return hot.empty(); }
+    int nodeCount() const { return static_cast<int>(hot.size()); }
+
+    /**
+     * @brief Looks the key up and splays it (or the last node visited) to the root.
+     * @return The value, nullptr if absent.
+     */
+    T* search(const key_type& key);
+
+    /**
+     * @brief Looks the key up without changing the tree.
+     */
+    const T* find(const key_type& key) const { return peek(key); }
+    T* find(const key_type& key) { return peek(key); }
+    bool contains(const key_type& key) const { return locate(key) != nil; }
+    const T* peek(const key_type& key) const;
+    T* peek(const key_type& key);
+
+    /**
+     * @brief Bidirectional iterator over the values in key order, stepping through the links.
+     */
+    template <bool Const>
+    class Iterator
+    {
+    public:
+        using iterator_category = bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = conditional_t<Const, const T*, T*>;
+        using reference = conditional_t<Const, const T&, T&>;
+
+        Iterator() = default;
+
+        /// A mutable iterator converts to a const one.
+        template <bool C = Const, class = enable_if_t<C>>
+        Iterator(const Iterator<false>& other) : tree(other.tree), node(other.node) {}
+
+        reference operator*() const { return tree->payload[node]; }
+        pointer operator->() const { return &tree->payload[node]; }
+
+        Iterator& operator++() { node = tree->nextIndex(node); return *this; }
+        Iterator operator++(int) { Iterator old = *this; ++*this; return old; }
+        Iterator& operator--() { node = node != nil ? tree->prevIndex(node) : tree->rightmost(tree->root); return *this; }
+        Iterator operator--(int) { Iterator old = *this; --*this; return old; }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.node == b.node; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.node != b.node; }
+
+    private:
+        friend class CompactSplayTree;
+        template <bool> friend class Iterator;
+        using Tree = conditional_t<Const, const CompactSplayTree, CompactSplayTree>;
+
+        Iterator(Tree* tree, index_type node) : tree(tree), node(node) {}
+
+        Tree* tree = nullptr;
+        index_type node = nil; ///< nil for end().
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    iterator begin() { return iterator(this, leftmost(root)); }
+    iterator end() { return iterator(this, nil); }
+    const_iterator begin() const { return const_iterator(this, leftmost(root)); }
+    const_iterator end() const { return const_iterator(this, nil); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    /**
+     * @brief First value whose key is not less than (upper_bound: greater than) key; the tree is not splayed.
+     */
+    iterator lower_bound(const key_type& key) { return iterator(this, lowerBoundIndex(key, false)); }
+    const_iterator lower_bound(const key_type& key) const { return const_iterator(this, lowerBoundIndex(key, false)); }
+    iterator upper_bound(const key_type& key) { return iterator(this, lowerBoundIndex(key, true)); }
+    const_iterator upper_bound(const key_type& key) const { return const_iterator(this, lowerBoundIndex(key, true)); }
+
+    /**
+     * @brief Number of levels: 0 when empty, 1 for a single node. Iterative, as in SplayTree.
+     */
+    int height() const;
+
+    /**
+     * @brief Histogram of node depths over every stride-th node in key order; index 0 counts the root.
+     */
+    vector<size_t> depthProfile(size_t stride = 1) const;
+
+    /**
+     * @brief Operation counters (all zero unless Traits::collectStats), see SplayStats.
+     *        nodeBytes counts the two array slots of every node, not the spare capacity.
+     */
+    SplayStats stats() const;
+    void resetStats();
+
+    /**
+     * @brief Bytes held by the arrays, including spare capacity.
+     */
+    size_t capacityBytes() const { return hot.capacity() * sizeof(HotNode) + payload.capacity() * sizeof(T); }
+
+    /**
+     * @brief Prints the leaves in key order, one per line.
+     */
+    void leafNodes(ostream& out = cout) const;
+
+    inline T getRootValue() const { return payload[root]; }
+
+    /**
+     * @brief Appends the values in key order.
+     */
+    vector<T>& collectInOrder(vector<T>& result) const;
+
+private:
+    struct HotNode
+    {
+        key_type key;
+        index_type left;
+        index_type right;
+        index_type parent;
+    };
+
+    vector<HotNode> hot;      ///< Keys and links, all a descent and a splay touch.
+    vector<T> payload;        ///< The values, same index as their node.
+    index_type root = nil;
+
+    /// Operation counters; an empty placeholder unless Traits::collectStats is set.
+    mutable conditional_t<Traits::collectStats, SplayStats, splay_detail::NoStats> counters;
+
+    static int compareKey(const key_type& key, const key_type& other) { return Traits::compare(key, other); }
+
+    /**
+     * @brief Appends an unlinked node holding the value built from args.
+     * @return Its index, always the last one.
+     */
+    template <class... Args>
+    index_type createNode(Args&&... args);
+
+    /**
+     * @brief Drops an unlinked node: the last node moves into its slot and its neighbours are relinked.
+     */
+    void releaseNode(index_type node);
+
+    /**
+     * @brief Shared insertion path, as SplayTree::insertWith.
+     * @param make Returns the index of a fresh unlinked node; only called when the key is absent.
+     */
+    template <class Make>
+    pair<index_type, bool> insertWith(const key_type& key, Make make);
+
+    /**
+     * @brief Plain descent to the key without splaying; nil if absent.
+     */
+    index_type locate(const key_type& key) const;
+
+    index_type lowerBoundIndex(const key_type& key, bool strict) const;
+
+    void splay(index_type node);
+
+    /**
+     * @brief Right rotation at node (its left child rises) and left rotation (its right child rises).
+     */
+    void zig(index_type node);
+    void zag(index_type node);
+
+    /**
+     * @brief Single-pass top-down splay, as SplayTree::splayTopDown.
+     * @param cmp Callable returning negative/zero/positive when the key is less than/equal to/greater than a node's key.
+     * @return The result of comparing the key with the new root's key.
+     * @warning The tree must not be empty.
+     */
+    template <class Cmp>
+    int splayTopDown(Cmp cmp);
+
+    void countDescent(size_t compared) const;
+    void countLookup(bool hit) const;
+
+    index_type nextIndex(index_type node) const;
+    index_type prevIndex(index_type node) const;
+    index_type leftmost(index_type node) const;
+    index_type rightmost(index_type node) const;
+
+    /**
+     * @brief Calls visit(index, depth) for every node of the subtree in key order, without a stack.
+     */
+    template <class Visit>
+    void walkDepths(index_type node, Visit visit) const;
+
+    /**
+     * @brief Fills empty arrays with the key-sorted batch as a balanced tree in breadth-first order.
+     */
+    void layoutBalanced(vector<T>& batch);
+
+    template <class Range>
+    static vector<T> sortedBatch(Range&& values);
+};
+
+/**
+ * @brief Overloads the << operator to print the tree in order.
+ */
+template <class T, class Traits>
+ostream& operator<<(ostream& out, const CompactSplayTree<T, Traits>& tree)
+{
+    tree.display(out);
+    return out;
+}
+
+/**
+ * @brief Overloads the >> operator to read one element into the tree.
+ */
+template <class T, class Traits>
+istream& operator>>(istream& in, CompactSplayTree<T, Traits>& tree)
+{
+    T data;
+    in >> data;
+    tree.insert(std::move(data));
+    return in;
+}
+
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::swap(CompactSplayTree& other) noexcept
+{
+    hot.swap(other.hot);
+    payload.swap(other.payload);
+    std::swap(root, other.root);
+    std::swap(counters, other.counters);
+}
+
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::clear()
+{
+    hot.clear();
+    payload.clear();
+    root = nil;
+}
+
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::reserve(size_t count)
+{
+    if (count > maxSize)
+        throw length_error("CompactSplayTree::reserve: more nodes than 32-bit indices can address");
+    hot.reserve(count);
+    payload.reserve(count);
+}
+
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::shrink_to_fit()
+{
+    hot.shrink_to_fit();
+    payload.shrink_to_fit();
+}
+
+/**
+ * @brief Appends a node to both arrays
+ * @param args Arguments forwarded to T's constructor
+ * @return Index of the new node, not yet linked into the tree
+ * @throws std::length_error when every index is taken; std::bad_alloc. The arrays are then unchanged.
+ */
+template <class T, class Traits>
+template <class... Args>
+typename CompactSplayTree<T, Traits>::index_type CompactSplayTree<T, Traits>::createNode(Args&&... args)
+{
+    if (hot.size() >= maxSize)
+        throw length_error("CompactSplayTree: more nodes than 32-bit indices can address");
+
+    payload.emplace_back(std::forward<Args>(args)...);
+    try
+    {
+        hot.push_back(HotNode{ Traits::keyOf(payload.back()), nil, nil, nil });
+    }
+    catch (...)
+    {
+        payload.pop_back();
+        throw;
+    }
+    return static_cast<index_type>(hot.size() - 1);
+}
+
+/**
+ * @brief Frees the slot of a node that is no longer linked
+ * @param node Index of the node; nothing may link to it any more
+ * @details The last node is moved into the slot, so its parent's child link (or the root) and
+ *          its children's parent links are redirected to the new index.
+ */
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::releaseNode(index_type node)
+{
+    const index_type last = static_cast<index_type>(hot.size() - 1);
+    if (node != last)
+    {
+        const HotNode& moved = hot[last];
+        const index_type parent = moved.parent;
+        if (parent == nil)
+            root = node;
+        else if (hot[parent].left == last)
+            hot[parent].left = node;
+        else
+            hot[parent].right = node;
+        if (moved.left != nil) hot[moved.left].parent = node;
+        if (moved.right != nil) hot[moved.right].parent = node;
+
+        hot[node] = moved;
+        payload[node] = std::move(payload[last]);
+    }
+    hot.pop_back();
+    payload.pop_back();
+}
+
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::insert(const T& value)
+{
+    insertWith(Traits::keyOf(value), [this, &value]() { return createNode(value); });
+}
+
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::insert(T&& value)
+{
+    insertWith(Traits::keyOf(value), [this, &value]() { return createNode(std::move(value)); });
+}
+
+template <class T, class Traits>
+template <class... Args>
+pair<T*, bool> CompactSplayTree<T, Traits>::emplace(Args&&... args)
+{
+    // The new node is the last one until it is linked, and splaying moves no slot
+    const index_type node = createNode(std::forward<Args>(args)...);
+    const key_type key = hot[node].key;
+    pair<index_type, bool> result = insertWith(key, [node]() { return node; });
+    if (!result.second)
+        releaseNode(node); // Duplicate, discard the constructed value
+    return { &payload[root], result.second };
+}
+
+template <class T, class Traits>
+template <class... Args>
+pair<T*, bool> CompactSplayTree<T, Traits>::try_emplace(const key_type& key, Args&&... args)
+{
+    pair<index_type, bool> result = insertWith(key, [&]() { return createNode(std::forward<Args>(args)...); });
+    return { &payload[result.first], result.second };
+}
+
+template <class T, class Traits>
+template <class V>
+pair<T*, bool> CompactSplayTree<T, Traits>::insert_or_assign(V&& value)
+{
+    pair<index_type, bool> result = insertWith(Traits::keyOf(value), [&]() { return createNode(std::forward<V>(value)); });
+    if (!result.second)
+        payload[result.first] = std::forward<V>(value); // Same key, hot needs no update
+    return { &payload[result.first], result.second };
+}
+
+/**
+ * @brief Common insertion path for insert, emplace, try_emplace and insert_or_assign
+ * @param key Key of the value being inserted
+ * @param make Returns the index of the node to link; called only when the key is absent
+ * @return Index of the node holding the key (now the root) and whether make() was linked
+ * @details BottomUp: descends to the key or the insertion point, links the new node as a leaf
+ *          and splays it. TopDown: splays around the key and puts the new node above the halves.
+ */
+template <class T, class Traits>
+template <class Make>
+pair<typename CompactSplayTree<T, Traits>::index_type, bool> CompactSplayTree<T, Traits>::insertWith(const key_type& key, Make make)
+{
+    if (root == nil)
+    {
+        root = make();
+        return { root, true };
+    }
+
+    if constexpr (Traits::mode == SplayMode::TopDown)
+    {
+        int result = splayTopDown([&key](const key_type& other) { return compareKey(key, other); });
+        if (result == 0) // Avoid duplicates, the existing node is already at the root
+            return { root, false };
+
+        const index_type node = make();
+        HotNode& fresh = hot[node];
+        HotNode& top = hot[root];
+        if (result < 0)
+        {
+            fresh.left = top.left;
+            fresh.right = root;
+            top.left = nil;
+        }
+        else
+        {
+            fresh.right = top.right;
+            fresh.left = root;
+            top.right = nil;
+        }
+        if (fresh.left != nil) hot[fresh.left].parent = node;
+        if (fresh.right != nil) hot[fresh.right].parent = node;
+        root = node;
+        return { root, true };
+    }
+    else
+    {
+        index_type at = root;
+        index_type parent = nil;
+        int result = 0;
+        size_t compared = 0;
+
+        while (at != nil)
+        {
+            result = compareKey(key, hot[at].key);
+            compared++;
+            if (result == 0) // Avoid duplicates
+            {
+                countDescent(compared);
+                splay(at);
+                return { root, false };
+            }
+
+            parent = at;
+            at = result < 0 ? hot[at].left : hot[at].right;
+        }
+        countDescent(compared);
+
+        // make() may grow the arrays, so no reference into them is held across it
+        const index_type node = make();
+        hot[node].parent = parent;
+        if (result < 0)
+            hot[parent].left = node;
+        else
+            hot[parent].right = node;
+
+        splay(node);
+        return { root, true };
+    }
+}
+
+template <class T, class Traits>
+template <class Range>
+void CompactSplayTree<T, Traits>::buildFrom(Range&& values)
+{
+    vector<T> batch = sortedBatch(std::forward<Range>(values));
+    if (batch.size() > maxSize)
+        throw length_error("CompactSplayTree::buildFrom: more nodes than 32-bit indices can address");
+
+    CompactSplayTree built;
+    built.layoutBalanced(batch);
+    std::swap(hot, built.hot);
+    std::swap(payload, built.payload);
+    root = built.root;
+}
+
+template <class T, class Traits>
+template <class Range>
+void CompactSplayTree<T, Traits>::mergeFrom(Range&& values)
+{
+    if (root == nil)
+    {
+        buildFrom(std::forward<Range>(values));
+        return;
+    }
+
+    vector<T> batch = sortedBatch(std::forward<Range>(values));
+    const size_t n = hot.size();
+    size_t logN = 0;
+    while ((size_t(1) << logN) < n) logN++;
+    if (batch.size() * logN < n)
+    {
+        for (T& value : batch)
+            insertWith(Traits::keyOf(value), [this, &value]() { return createNode(std::move(value)); });
+        return;
+    }
+
+    vector<T> merged;
+    merged.reserve(n + batch.size());
+    auto it = begin();
+    for (T& value : batch)
+    {
+        int cmp = 1;
+        while (it != end() && (cmp = compareKey(Traits::keyOf(value), hot[it.node].key)) > 0)
+            merged.push_back(*it++);
+        if (it != end() && cmp == 0)
+            continue; // Key already present, the existing element wins
+        merged.push_back(std::move(value));
+    }
+    merged.insert(merged.end(), it, end());
+    buildFrom(std::move(merged));
+}
+
+/**
+ * @brief Places nodes[lo, hi) of the sorted batch breadth-first: the queue position of a range is the slot of its middle node
+ * @param batch Values in strictly ascending key order; they are moved out
+ */
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::layoutBalanced(vector<T>& batch)
+{
+    struct Range
+    {
+        size_t lo, hi;
+        index_type parent;
+        bool left;
+    };
+
+    const size_t n = batch.size();
+    reserve(n);
+    if (n == 0)
+        return;
+
+    vector<Range> queue;
+    queue.reserve(n);
+    queue.push_back(Range{ 0, n, nil, false });
+    for (size_t head = 0; head < queue.size(); head++)
+    {
+        const Range range = queue[head];
+        const size_t mid = range.lo + (range.hi - range.lo) / 2;
+        const index_type node = static_cast<index_type>(head);
+
+        payload.push_back(std::move(batch[mid]));
+        hot.push_back(HotNode{ Traits::keyOf(payload.back()), nil, nil, range.parent });
+        if (range.parent != nil)
+            (range.left ? hot[range.parent].left : hot[range.parent].right) = node;
+
+        if (range.lo < mid) queue.push_back(Range{ range.lo, mid, node, true });
+        if (mid + 1 < range.hi) queue.push_back(Range{ mid + 1, range.hi, node, false });
+    }
+    root = 0;
+}
+
+/**
+ * @brief Sorts a range by key and drops duplicate keys, keeping the first, as SplayTree does for its bulk loads
+ */
+template <class T, class Traits>
+template <class Range>
+vector<T> CompactSplayTree<T, Traits>::sortedBatch(Range&& values)
+{
+    vector<T> batch;
+    if constexpr (is_same<decay_t<Range>, vector<T>>::value && !is_lvalue_reference<Range>::value)
+        batch = std::move(values);
+    else
+        batch.assign(std::begin(values), std::end(values));
+
+    auto less = [](const T& a, const T& b) { return Traits::compare(Traits::keyOf(a), Traits::keyOf(b)) < 0; };
+    if (adjacent_find(batch.begin(), batch.end(), [&less](const T& a, const T& b) { return !less(a, b); }) == batch.end())
+        return batch; // Already strictly ascending, nothing to sort or drop
+
+    if (batch.size() >= Traits::parallelSortThreshold)
+        splay_detail::parallelStableSort(batch.begin(), batch.end(), less);
+    else
+        stable_sort(batch.begin(), batch.end(), less);
+
+    auto sameKey = [](const T& a, const T& b) { return Traits::compare(Traits::keyOf(a), Traits::keyOf(b)) == 0; };
+    batch.erase(unique(batch.begin(), batch.end(), sameKey), batch.end());
+    return batch;
+}
+
+/**
+ * @brief Removes the value with the key, as SplayTree::erase
+ * @details The node is splayed to the root and its left part splayed on its maximum, which then
+ *          takes the right part as its right child. The freed slot is refilled with the last node.
+ */
+template <class T, class Traits>
+bool CompactSplayTree<T, Traits>::erase(const key_type& key)
+{
+    if (root == nil) return false;
+
+    if constexpr (Traits::mode == SplayMode::TopDown)
+    {
+        if (splayTopDown([&key](const key_type& other) { return compareKey(key, other); }) != 0)
+            return false; // Not found - the last accessed node is already at the root
+    }
+    else
+    {
+        index_type at = root;
+        index_type lastVisited = nil;
+        size_t compared = 0;
+        while (at != nil)
+        {
+            int cmp = compareKey(key, hot[at].key);
+            compared++;
+            if (cmp == 0) break;
+            lastVisited = at;
+            at = cmp < 0 ? hot[at].left : hot[at].right;
+        }
+        countDescent(compared);
+
+        if (at == nil)
+        {
+            splay(lastVisited);
+            return false;
+        }
+        splay(at);
+    }
+
+    const index_type removed = root;
+    const index_type leftTree = hot[removed].left;
+    const index_type rightTree = hot[removed].right;
+
+    if (leftTree == nil || (Traits::mode == SplayMode::BottomUp && rightTree == nil))
+    {
+        // One part is empty, the other becomes the tree as it is
+        root = leftTree == nil ? rightTree : leftTree;
+        if (root != nil) hot[root].parent = nil;
+    }
+    else
+    {
+        hot[leftTree].parent = nil;
+        root = leftTree;
+        if constexpr (Traits::mode == SplayMode::TopDown)
+            splayTopDown([](const key_type&) { return 1; }); // Maximum of the left part
+        else
+            splay(rightmost(leftTree));
+
+        // The maximum of the left part has no right child
+        hot[root].right = rightTree;
+        if (rightTree != nil) hot[rightTree].parent = root;
+    }
+
+    releaseNode(removed);
+    return true;
+}
+
+template <class T, class Traits>
+T* CompactSplayTree<T, Traits>::search(const key_type& key)
+{
+    if constexpr (Traits::mode == SplayMode::TopDown)
+    {
+        if (root == nil) return nullptr;
+        int cmp = splayTopDown([&key](const key_type& other) { return compareKey(key, other); });
+        countLookup(cmp == 0);
+        return cmp == 0 ? &payload[root] : nullptr;
+    }
+    else
+    {
+        index_type at = root;
+        index_type parent = nil;
+        size_t compared = 0;
+
+        while (at != nil)
+        {
+            int cmp = compareKey(key, hot[at].key);
+            compared++;
+            if (cmp == 0)
+            {
+                countDescent(compared);
+                countLookup(true);
+                splay(at);
+                return &payload[at];
+            }
+
+            parent = at;
+            at = cmp < 0 ? hot[at].left : hot[at].right;
+        }
+
+        countDescent(compared);
+        countLookup(false);
+        if (parent != nil)
+            splay(parent);
+        return nullptr;
+    }
+}
+
+template <class T, class Traits>
+typename CompactSplayTree<T, Traits>::index_type CompactSplayTree<T, Traits>::locate(const key_type& key) const
+{
+    index_type at = root;
+    size_t compared = 0;
+
+    while (at != nil)
+    {
+        int cmp = compareKey(key, hot[at].key);
+        compared++;
+        if (cmp == 0)
+            break;
+        at = cmp < 0 ? hot[at].left : hot[at].right;
+    }
+
+    countDescent(compared);
+    countLookup(at != nil);
+    return at;
+}
+
+template <class T, class Traits>
+const T* CompactSplayTree<T, Traits>::peek(const key_type& key) const
+{
+    index_type node = locate(key);
+    return node != nil ? &payload[node] : nullptr;
+}
+
+template <class T, class Traits>
+T* CompactSplayTree<T, Traits>::peek(const key_type& key)
+{
+    index_type node = locate(key);
+    return node != nil ? &payload[node] : nullptr;
+}
+
+template <class T, class Traits>
+typename CompactSplayTree<T, Traits>::index_type CompactSplayTree<T, Traits>::lowerBoundIndex(const key_type& key, bool strict) const
+{
+    index_type at = root;
+    index_type bound = nil;
+
+    while (at != nil)
+    {
+        int cmp = compareKey(key, hot[at].key);
+        if (cmp < 0 || (cmp == 0 && !strict))
+        {
+            bound = at;
+            at = hot[at].left;
+        }
+        else
+            at = hot[at].right;
+    }
+
+    return bound;
+}
+
+/*
+ * @brief Bottom-up splay of node to the root by zig, zig-zig and zig-zag steps, as SplayTree::splay
+ */
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::splay(index_type node)
+{
+    while (node != root)
+    {
+        const index_type parent = hot[node].parent;
+        if (parent == root)
+        {
+            if constexpr (Traits::collectStats) counters.zigSteps++;
+            if (node == hot[parent].left)
+                zig(parent);
+            else
+                zag(parent);
+            continue;
+        }
+
+        const index_type grandParent = hot[parent].parent;
+        const bool nodeLeft = node == hot[parent].left;
+        const bool parentLeft = parent == hot[grandParent].left;
+        if constexpr (Traits::collectStats)
+            (nodeLeft == parentLeft ? counters.zigZigSteps : counters.zigZagSteps)++;
+
+        if (nodeLeft)
+        {
+            if (parentLeft) { zig(grandParent); zig(parent); }
+            else { zig(parent); zag(grandParent); }
+        }
+        else
+        {
+            if (parentLeft) { zag(parent); zig(grandParent); }
+            else { zag(grandParent); zag(parent); }
+        }
+    }
+}
+
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::zig(index_type node)
+{
+    const index_type pivot = hot[node].left;
+    const index_type parent = hot[node].parent;
+
+    hot[node].left = hot[pivot].right;
+    if (hot[pivot].right != nil)
+        hot[hot[pivot].right].parent = node;
+
+    hot[pivot].parent = parent;
+    if (parent == nil)
+        root = pivot;
+    else if (hot[parent].left == node)
+        hot[parent].left = pivot;
+    else
+        hot[parent].right = pivot;
+
+    hot[pivot].right = node;
+    hot[node].parent = pivot;
+    if constexpr (Traits::collectStats) counters.rotations++;
+}
+
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::zag(index_type node)
+{
+    const index_type pivot = hot[node].right;
+    const index_type parent = hot[node].parent;
+
+    hot[node].right = hot[pivot].left;
+    if (hot[pivot].left != nil)
+        hot[hot[pivot].left].parent = node;
+
+    hot[pivot].parent = parent;
+    if (parent == nil)
+        root = pivot;
+    else if (hot[parent].left == node)
+        hot[parent].left = pivot;
+    else
+        hot[parent].right = pivot;
+
+    hot[pivot].left = node;
+    hot[node].parent = pivot;
+    if constexpr (Traits::collectStats) counters.rotations++;
+}
+
+/**
+ * @brief Top-down splay toward a key, the index version of SplayTree::splayTopDown
+ * @details Nodes smaller than the key hang off the right spine of a left tree, larger ones off the
+ *          left spine of a right tree; a zig-zig or zag-zag step rotates first. Both side trees are
+ *          reassembled under the final node, and parent links are kept for iterators and erase.
+ */
+template <class T, class Traits>
+template <class Cmp>
+int CompactSplayTree<T, Traits>::splayTopDown(Cmp compareWith)
+{
+    auto cmp = [this, &compareWith](index_type node) {
+        if constexpr (Traits::collectStats) counters.comparisons++;
+        return compareWith(hot[node].key);
+    };
+    size_t links = 0;   // Nodes moved into the side trees
+    size_t rotated = 0; // Of those, the ones rotated first
+
+    index_type t = root;
+    index_type leftRoot = nil, leftMax = nil;   // Nodes known to be smaller than the key
+    index_type rightRoot = nil, rightMin = nil; // Nodes known to be larger than the key
+
+    int result = cmp(t);
+    while (result != 0)
+    {
+        if (result < 0)
+        {
+            index_type child = hot[t].left;
+            if (child == nil) break;
+            int childResult = cmp(child);
+
+            if (childResult < 0 && hot[child].left != nil)
+            {
+                // zig-zig: rotate right before linking
+                rotated++;
+                hot[t].left = hot[child].right;
+                if (hot[child].right != nil) hot[hot[child].right].parent = t;
+                hot[child].right = t;
+                hot[t].parent = child;
+                t = child;
+                child = hot[t].left;
+                childResult = cmp(child);
+            }
+
+            // Link t into the right tree as its new minimum
+            if (rightMin != nil) { hot[rightMin].left = t; hot[t].parent = rightMin; }
+            else rightRoot = t;
+            rightMin = t;
+
+            t = child;
+            result = childResult;
+        }
+        else
+        {
+            index_type child = hot[t].right;
+            if (child == nil) break;
+            int childResult = cmp(child);
+
+            if (childResult > 0 && hot[child].right != nil)
+            {
+                // zag-zag: rotate left before linking
+                rotated++;
+                hot[t].right = hot[child].left;
+                if (hot[child].left != nil) hot[hot[child].left].parent = t;
+                hot[child].left = t;
+                hot[t].parent = child;
+                t = child;
+                child = hot[t].right;
+                childResult = cmp(child);
+            }
+
+            // Link t into the left tree as its new maximum
+            if (leftMax != nil) { hot[leftMax].right = t; hot[t].parent = leftMax; }
+            else leftRoot = t;
+            leftMax = t;
+
+            t = child;
+            result = childResult;
+        }
+        links++;
+    }
+
+    if constexpr (Traits::collectStats)
+    {
+        counters.rotations += rotated;
+        counters.zigZigSteps += rotated;
+        counters.zigSteps += links - rotated;
+        counters.recordDepth(links + rotated);
+    }
+
+    // Reassemble: t's subtrees go to the inner spines, the side trees become t's children
+    if (leftMax != nil)
+    {
+        hot[leftMax].right = hot[t].left;
+        if (hot[t].left != nil) hot[hot[t].left].parent = leftMax;
+        hot[t].left = leftRoot;
+        hot[leftRoot].parent = t;
+    }
+    if (rightMin != nil)
+    {
+        hot[rightMin].left = hot[t].right;
+        if (hot[t].right != nil) hot[hot[t].right].parent = rightMin;
+        hot[t].right = rightRoot;
+        hot[rightRoot].parent = t;
+    }
+    hot[t].parent = nil;
+    root = t;
+    return result;
+}
+
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::countDescent(size_t compared) const
+{
+    if constexpr (Traits::collectStats)
+    {
+        if (compared == 0)
+            return;
+        counters.comparisons += compared;
+        counters.recordDepth(compared - 1);
+    }
+}
+
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::countLookup(bool hit) const
+{
+    if constexpr (Traits::collectStats)
+        (hit ? counters.hits : counters.misses)++;
+}
+
+template <class T, class Traits>
+SplayStats CompactSplayTree<T, Traits>::stats() const
+{
+    SplayStats result;
+    if constexpr (Traits::collectStats)
+        result = counters;
+    result.liveNodes = hot.size();
+    result.nodeBytes = result.liveNodes * (sizeof(HotNode) + sizeof(T));
+    return result;
+}
+
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::resetStats()
+{
+    if constexpr (Traits::collectStats)
+        counters = SplayStats();
+}
+
+template <class T, class Traits>
+typename CompactSplayTree<T, Traits>::index_type CompactSplayTree<T, Traits>::nextIndex(index_type node) const
+{
+    if (hot[node].right != nil)
+        return leftmost(hot[node].right);
+    while (hot[node].parent != nil && node == hot[hot[node].parent].right)
+        node = hot[node].parent;
+    return hot[node].parent;
+}
+
+template <class T, class Traits>
+typename CompactSplayTree<T, Traits>::index_type CompactSplayTree<T, Traits>::prevIndex(index_type node) const
+{
+    if (hot[node].left != nil)
+        return rightmost(hot[node].left);
+    while (hot[node].parent != nil && node == hot[hot[node].parent].left)
+        node = hot[node].parent;
+    return hot[node].parent;
+}
+
+template <class T, class Traits>
+typename CompactSplayTree<T, Traits>::index_type CompactSplayTree<T, Traits>::leftmost(index_type node) const
+{
+    while (node != nil && hot[node].left != nil)
+        node = hot[node].left;
+    return node;
+}
+
+template <class T, class Traits>
+typename CompactSplayTree<T, Traits>::index_type CompactSplayTree<T, Traits>::rightmost(index_type node) const
+{
+    while (node != nil && hot[node].right != nil)
+        node = hot[node].right;
+    return node;
+}
+
+/**
+ * @brief In-order walk with depths over the links, as SplayTree::walkDepths
+ */
+template <class T, class Traits>
+template <class Visit>
+void CompactSplayTree<T, Traits>::walkDepths(index_type node, Visit visit) const
+{
+    if (node == nil)
+        return;
+
+    size_t depth = 0;
+    while (hot[node].left != nil) { node = hot[node].left; depth++; }
+
+    for (;;)
+    {
+        visit(node, depth);
+
+        if (hot[node].right != nil)
+        {
+            node = hot[node].right;
+            depth++;
+            while (hot[node].left != nil) { node = hot[node].left; depth++; }
+            continue;
+        }
+
+        // Climb while coming from a right child; the subtree is done once its root is left behind
+        while (depth > 0 && node == hot[hot[node].parent].right) { node = hot[node].parent; depth--; }
+        if (depth == 0)
+            return;
+        node = hot[node].parent;
+        depth--;
+    }
+}
+
+template <class T, class Traits>
+int CompactSplayTree<T, Traits>::height() const
+{
+    if (root == nil)
+        return 0;
+    size_t deepest = 0;
+    walkDepths(root, [&deepest](index_type, size_t depth) { if (depth > deepest) deepest = depth; });
+    return static_cast<int>(deepest + 1);
+}
+
+template <class T, class Traits>
+vector<size_t> CompactSplayTree<T, Traits>::depthProfile(size_t stride) const
+{
+    vector<size_t> profile;
+    if (stride == 0) stride = 1;
+    size_t index = 0;
+    walkDepths(root, [&](index_type, size_t depth) {
+        if (index++ % stride != 0)
+            return;
+        if (depth >= profile.size())
+            profile.resize(depth + 1);
+        profile[depth]++;
+    });
+    return profile;
+}
+
+template <class T, class Traits>
+vector<T>& CompactSplayTree<T, Traits>::collectInOrder(vector<T>& result) const
+{
+    result.reserve(result.size() + hot.size());
+    result.insert(result.end(), begin(), end());
+    return result;
+}
+
+/**
+ * @brief Prints the values in order (mode 0) or preorder (mode 1); the preorder walk climbs the parent links
+ */
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::display(ostream& out, int displayMode) const
+{
+    if (empty())
+    {
+        cerr << "Cannot traverse an empty tree!" << endl;
+        return;
+    }
+    if (displayMode != 1)
+    {
+        walkDepths(root, [this, &out](index_type node, size_t) { out << payload[node] << " "; });
+        return;
+    }
+
+    index_type node = root;
+    while (node != nil)
+    {
+        out << payload[node] << " ";
+        if (hot[node].left != nil)
+            node = hot[node].left;
+        else if (hot[node].right != nil)
+            node = hot[node].right;
+        else
+        {
+            // Climb to the nearest ancestor whose right subtree is still to come
+            while (node != root && (node == hot[hot[node].parent].right || hot[hot[node].parent].right == nil))
+                node = hot[node].parent;
+            node = node == root ? nil : hot[hot[node].parent].right;
+        }
+    }
+}
+
+template <class T, class Traits>
+void CompactSplayTree<T, Traits>::leafNodes(ostream& out) const
+{
+    if (empty())
+    {
+        cerr << "Empty Tree!!";
+        return;
+    }
+    walkDepths(root, [this, &out](index_type node, size_t) {
+        if (hot[node].left == nil && hot[node].right == nil)
+            out << payload[node] << endl;
+    });
+}
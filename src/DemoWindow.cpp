@@ -1,12 +1,14 @@
 #include "DemoWindow.h"
 
 DemoWindow::DemoWindow(AccountDAL* dal, QWidget* parent)
-    : QWidget(parent), scene(new QGraphicsScene(this)), view(new QGraphicsView(scene, this)), DAL(*dal) {
+    : QWidget(parent), scene(new QGraphicsScene(this)), view(new QGraphicsView(scene, this)), DAL(*dal),
+      renderer(scene), replayTimer(new QTimer(this)) {
 
     QVBoxLayout* layout = new QVBoxLayout(this);
     layout->addWidget(view);
 
     view->setScene(scene);
+    view->setDragMode(QGraphicsView::ScrollHandDrag);
     view->show();
 
     
@@ -18,12 +20,39 @@ DemoWindow::DemoWindow(AccountDAL* dal, QWidget* parent)
     // Buttons
     QPushButton* triggerButton = new QPushButton("Trigger Splay", this);
     QPushButton* restartButton = new QPushButton("Restart Tree", this);
+    QPushButton* loadAllButton = new QPushButton("Load All Accounts", this);
     QPushButton* closeButton = new QPushButton("Close Window", this);
 
     layout->addWidget(triggerButton);
     layout->addWidget(restartButton);
+    layout->addWidget(loadAllButton);
     layout->addWidget(closeButton);
 
+    // Replay controls: speed, pause/resume and single steps
+    QHBoxLayout* replayLayout = new QHBoxLayout();
+    QSlider* speedSlider = new QSlider(Qt::Horizontal, this);
+    speedSlider->setRange(50, 2000);
+    speedSlider->setValue(1000);
+    speedSlider->setInvertedAppearance(true); // Right is faster
+    pauseButton = new QPushButton("Pause", this);
+    QPushButton* stepButton = new QPushButton("Step", this);
+    replayStatus = new QLabel(this);
+
+    // Nodes below this depth are folded into a "+n" marker
+    QSpinBox* depthLimit = new QSpinBox(this);
+    depthLimit->setRange(2, 40);
+    depthLimit->setValue(12);
+    renderer.setDepthLimit(depthLimit->value());
+
+    replayLayout->addWidget(new QLabel("Speed", this));
+    replayLayout->addWidget(speedSlider);
+    replayLayout->addWidget(pauseButton);
+    replayLayout->addWidget(stepButton);
+    replayLayout->addWidget(replayStatus);
+    replayLayout->addWidget(new QLabel("Depth limit", this));
+    replayLayout->addWidget(depthLimit);
+    layout->addLayout(replayLayout);
+
     connect(triggerButton, &QPushButton::clicked, [this, inputField]() {
         bool ok;
         int id = inputField->text().toInt(&ok);
@@ -36,74 +65,156 @@ DemoWindow::DemoWindow(AccountDAL* dal, QWidget* parent)
         });
 
     connect(restartButton, &QPushButton::clicked, this, &DemoWindow::restartTree);
+    connect(loadAllButton, &QPushButton::clicked, this, &DemoWindow::loadAllAccounts);
     connect(closeButton, &QPushButton::clicked, this, &DemoWindow::closeWindow);
+    connect(speedSlider, &QSlider::valueChanged, this, &DemoWindow::setReplaySpeed);
+    connect(pauseButton, &QPushButton::clicked, this, &DemoWindow::togglePause);
+    connect(stepButton, &QPushButton::clicked, this, &DemoWindow::stepReplay);
+    connect(replayTimer, &QTimer::timeout, this, &DemoWindow::replayStep);
+    connect(depthLimit, QOverload<int>::of(&QSpinBox::valueChanged), [this](int depth) {
+        renderer.setDepthLimit(depth);
+        displayTree();
+        });
+
+    replayTimer->setInterval(speedSlider->value());
 
-    scene->setSceneRect(-1000, -1000, 2000, 2000);
     setLayout(layout);
     setWindowTitle("Splay Tree Demo");
     resize(1800, 700);
 
-    demoTree = DAL.getDemoAccounts();
+    loadDemoTree();
     qDebug() << "Loaded demo accounts:" << demoTree.nodeCount();
 
-    demoTree.setOnRotationCallback([this](SplayTree<Account>::NodeType* root) {
-        QMetaObject::invokeMethod(this, [this, root]() {
-            displayTree(root);
-            }, Qt::QueuedConnection);
+    updateReplayStatus();
+    displayTree();
+}
 
-        QThread::msleep(1000);
-        QCoreApplication::processEvents();
-        });
+void DemoWindow::displayTree() {
+    renderer.refresh(shape);
+    scene->setSceneRect(renderer.bounds(shape));
+}
 
-    displayTree(demoTree.getRoot());
+void DemoWindow::triggerSplay(int id) {
+    // The shape has to match the tree before the next operation's steps can apply to it
+    finishReplay();
+
+    demoTree.observer().steps.clear();
+    auto foundNode = demoTree.search(id);
+    if (!foundNode)
+        qDebug() << "Account" << id << "not found, replaying the splay of the last account visited";
+
+    for (RotationStep<Key>& step : demoTree.observer().steps)
+        pendingSteps.push_back(std::move(step));
+    demoTree.observer().steps.clear();
+    traceLength = pendingSteps.size();
+
+    if (!paused && !pendingSteps.empty())
+        replayTimer->start();
+    updateReplayStatus();
 }
 
-void DemoWindow::displayTree(SplayTree<Account>::NodeType* root) {
-    scene->clear();
-    qDebug() << "Displaying tree with" << demoTree.nodeCount() << "accounts";
-    displayNode(root, 0, 0, 150);
-    scene->update();
-    view->viewport()->update();
+void DemoWindow::replayStep() {
+    if (pendingSteps.empty()) {
+        replayTimer->stop();
+        return;
+    }
+
+    const RotationStep<Key>& step = pendingSteps.front();
+    shape.apply(step);
+    if (step.kind == RotationKind::TopDown)
+        renderer.refresh(shape);
+    else
+        renderer.refreshSubtree(shape, step.pivot); // A rotation only moves the pivot's new subtree
+    pendingSteps.pop_front();
+    if (pendingSteps.empty())
+        replayTimer->stop();
+
+    updateReplayStatus();
 }
 
-void DemoWindow::displayNode(SplayTree<Account>::NodeType* node, int x, int y, int offset) {
-    if (!node) return;
+void DemoWindow::stepReplay() {
+    if (!paused)
+        togglePause();
+    replayStep();
+}
 
-    QString text = QString::number(node->data.getCustomerID());
-    QGraphicsTextItem* item = scene->addText(text);
-    item->setPos(x, y);
+void DemoWindow::togglePause() {
+    paused = !paused;
+    pauseButton->setText(paused ? "Resume" : "Pause");
+    if (paused)
+        replayTimer->stop();
+    else if (!pendingSteps.empty())
+        replayTimer->start();
+}
 
-    if (node->left) {
-        scene->addLine(x + 10, y + 10, x - offset + 10, y + 50);
-        displayNode(node->left, x - offset, y + 60, offset /1.2);
-    }
+void DemoWindow::setReplaySpeed(int msPerStep) {
+    replayTimer->setInterval(msPerStep);
+}
 
-    if (node->right) {
-        scene->addLine(x + 10, y + 10, x + offset + 10, y + 50);
-        displayNode(node->right, x + offset, y + 60, offset / 1.2);
+void DemoWindow::finishReplay() {
+    if (pendingSteps.empty())
+        return;
+
+    replayTimer->stop();
+    while (!pendingSteps.empty()) {
+        shape.apply(pendingSteps.front());
+        pendingSteps.pop_front();
     }
+    displayTree();
 }
 
-void DemoWindow::triggerSplay(int id) {
-    Account targetAccount(id);
-    auto foundNode = demoTree.search(targetAccount);
-    if (foundNode) {
-        updateTreeDisplay();
-    }
+void DemoWindow::updateReplayStatus() {
+    replayStatus->setText(QString("Step %1 / %2").arg(traceLength - pendingSteps.size()).arg(traceLength));
 }
 
 void DemoWindow::updateTreeDisplay() {
-    displayTree(demoTree.getRoot());
+    finishReplay();
+    displayTree();
+}
+
+// Rebuilds the demo tree the way AccountDAL::getDemoAccounts does; the inserts are not animated
+void DemoWindow::loadDemoTree() {
+    replayTimer->stop();
+    pendingSteps.clear();
+    traceLength = 0;
+
+    demoTree.clear();
+    for (const Account& acc : AccountDAL::getDemoAccountList())
+        demoTree.insert(acc);
+    captureShape();
+}
+
+void DemoWindow::captureShape() {
+    demoTree.observer().steps.clear();
+    shape.capture(demoTree.getRoot(), [](const DemoAccountTree::NodeType* node) { return node->data.getCustomerID(); });
+}
+
+// Shows the real account tree; only its top levels and recently splayed paths get items
+void DemoWindow::loadAllAccounts() {
+    replayTimer->stop();
+    pendingSteps.clear();
+    traceLength = 0;
+
+    demoTree.buildFrom(DAL.getAllAccounts());
+    captureShape();
+    qDebug() << "Loaded" << demoTree.nodeCount() << "accounts into the demo tree";
+
+    updateReplayStatus();
+    displayTree();
+    if (shape.root())
+        view->centerOn(renderer.position(*shape.root()));
 }
 
 //  New slot: Restart the tree completely
 void DemoWindow::restartTree() {
-    demoTree = DAL.getDemoAccounts();
+    loadDemoTree();
     qDebug() << "Tree restarted with" << demoTree.nodeCount() << "accounts.";
-    displayTree(demoTree.getRoot());
+    updateReplayStatus();
+    displayTree();
 }
 
 //  New slot: Close the window
 void DemoWindow::closeWindow() {
+    replayTimer->stop();
     this->close();
 }
@@ -7,40 +7,84 @@
 #include <QLabel>
 #include <QGraphicsTextItem>
 #include <QCoreApplication>
-#include <QMetaObject>
-#include <QThread>
+#include <QTimer>
+#include <QSlider>
+#include <QHBoxLayout>
 #include <QPropertyAnimation>
 #include <QGraphicsItem>
 #include <QGraphicsLineItem>
 #include <QLineEdit>
+#include <QSpinBox>
 
 #include "SplayTree.h"
 #include "Account.h"
 #include "AccountDAL.h"
+#include "RotationTrace.h"
+#include "TreeRenderer.h"
+#include <deque>
+
+/**
+ * @brief Account traits of the demo tree: as AccountTraits, plus an observer that records each rotation by customer ID.
+ */
+struct DemoAccountTraits : AccountTraits
+{
+    template <class Node>
+    using observer = RotationTraceObserver<Node, AccountTraits>;
+};
+
+using DemoAccountTree = PooledSplayTree<Account, DemoAccountTraits>;
 
 class DemoWindow : public QWidget {
     Q_OBJECT
 private slots:
     void restartTree();
+    void loadAllAccounts();
     void closeWindow();
+    void replayStep();
+    void stepReplay();
+    void togglePause();
+    void setReplaySpeed(int msPerStep);
 
 
 public:
     DemoWindow(AccountDAL* dal, QWidget* parent = nullptr);
     ~DemoWindow() {}
 
-    void displayTree(SplayTree<Account>::NodeType*);
+    /*
+     * @brief Draws the displayed shape, which trails the tree while a trace is replayed
+     * @note Only updates the items that changed; replay steps redraw just the rotated subtree
+     */
+    void displayTree();
+
+    /*
+     * @brief Splays the ID at full speed, then animates the recorded rotations one timer tick each
+     */
     void triggerSplay(int id);
 
 private:
+    using Key = AccountTraits::key_type;
+
     QGraphicsView* view;
     QGraphicsScene* scene;
     AccountDAL& DAL;
-    SplayTree<Account> demoTree;
+    DemoAccountTree demoTree;
     QLineEdit* splayInput;
+    TreeRenderer renderer;
+
+    QTimer* replayTimer;
+    QPushButton* pauseButton;
+    QLabel* replayStatus;
+
+    TreeShape<Key> shape;                  ///< The tree as drawn: its state before the pending steps.
+    std::deque<RotationStep<Key>> pendingSteps;
+    size_t traceLength = 0;
+    bool paused = false;
 
     void updateTreeDisplay();
-    void displayNode(SplayTree<Account>::NodeType* node, int x, int y, int offset);
+    void loadDemoTree();
+    void finishReplay();
+    void updateReplayStatus();
+    void captureShape();
     
     //void updateNodePosition(QGraphicsTextItem* nodeItem, int level, int position);
 
@@ -0,0 +1,229 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+#include <type_traits>
+using namespace std;
+
+/**
+ * @brief A slab arena handing out fixed-size slots carved from large contiguous blocks.
+ *
+ * The slot size is fixed by the first allocation (the node type of the container using it).
+ * Freed slots go onto an intrusive free list and are reused before a new block is carved.
+ * Requests of any other size fall through to the global operator new, so the pool can safely
+ * back a rebound allocator.
+ */
+class NodePool
+{
+public:
+    /**
+     * @brief Creates an empty pool. No memory is reserved until the first allocation.
+     * @param maxSlotsPerBlock Upper bound for the geometric block growth.
+     */
+    explicit NodePool(size_t maxSlotsPerBlock = 65536) : maxSlotsPerBlock(maxSlotsPerBlock) {}
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    /**
+     * @brief Destructor. Returns every block to the system.
+     */
+    ~NodePool() { release(); }
+
+    /**
+     * @brief Allocates a slot of the given size.
+     * @param bytes Requested size in bytes.
+     * @return Pointer to uninitialized storage, suitably aligned for any scalar type.
+     */
+    void* allocate(size_t bytes);
+
+    /**
+     * @brief Returns a slot previously obtained from allocate() with the same size.
+     */
+    void deallocate(void* ptr, size_t bytes) noexcept;
+
+    /**
+     * @brief Frees every block at once. All outstanding slots become invalid.
+     * @warning Object destructors are not run; callers must only use it for trivially destructible payloads.
+     */
+    void release() noexcept;
+
+    size_t slotSize() const { return slotBytes; }         ///< Size of one slot, 0 before the first allocation.
+    size_t slotsInUse() const { return inUse; }           ///< Slots currently handed out.
+    size_t blockCount() const { return blocks.size(); }   ///< Number of blocks obtained from the system.
+    size_t reservedBytes() const { return reserved; }     ///< Total bytes held by the pool.
+
+private:
+    struct FreeSlot { FreeSlot* next; };
+
+    static size_t roundUp(size_t bytes)
+    {
+        const size_t align = alignof(max_align_t);
+        if (bytes < sizeof(FreeSlot)) bytes = sizeof(FreeSlot);
+        return (bytes + align - 1) & ~(align - 1);
+    }
+
+    void grow();
+
+    size_t slotBytes = 0;
+    size_t nextBlockSlots = 32;
+    size_t maxSlotsPerBlock;
+    size_t inUse = 0;
+    size_t reserved = 0;
+    char* cursor = nullptr;
+    char* blockEnd = nullptr;
+    FreeSlot* freeList = nullptr;
+    vector<void*> blocks;
+};
+
+inline void* NodePool::allocate(size_t bytes)
+{
+    const size_t rounded = roundUp(bytes);
+    if (slotBytes == 0)
+        slotBytes = rounded;
+
+    if (rounded != slotBytes)
+        return ::operator new(bytes);
+
+    ++inUse;
+    if (freeList)
+    {
+        FreeSlot* slot = freeList;
+        freeList = slot->next;
+        return slot;
+    }
+
+    if (cursor == blockEnd)
+    {
+        try { grow(); }
+        catch (...) { --inUse; throw; }
+    }
+
+    void* slot = cursor;
+    cursor += slotBytes;
+    return slot;
+}
+
+inline void NodePool::deallocate(void* ptr, size_t bytes) noexcept
+{
+    if (!ptr) return;
+
+    if (roundUp(bytes) != slotBytes)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+
+    FreeSlot* slot = static_cast<FreeSlot*>(ptr);
+    slot->next = freeList;
+    freeList = slot;
+    --inUse;
+}
+
+inline void NodePool::grow()
+{
+    const size_t bytes = slotBytes * nextBlockSlots;
+    char* block = static_cast<char*>(::operator new(bytes));
+    try { blocks.push_back(block); }
+    catch (...) { ::operator delete(block); throw; }
+
+    cursor = block;
+    blockEnd = block + bytes;
+    reserved += bytes;
+    if (nextBlockSlots < maxSlotsPerBlock)
+        nextBlockSlots *= 2;
+}
+
+inline void NodePool::release() noexcept
+{
+    for (void* block : blocks)
+        ::operator delete(block);
+    blocks.clear();
+    cursor = blockEnd = nullptr;
+    freeList = nullptr;
+    inUse = 0;
+    reserved = 0;
+    nextBlockSlots = 32;
+}
+
+/**
+ * @brief Standard-conforming allocator backed by a shared NodePool.
+ *
+ * Copies (including rebound copies) share one pool, so a container's node allocator and
+ * the allocator handed to its constructor draw from the same arena. Copy-constructing a
+ * container gives the copy a fresh pool of its own. The pool object is created by the default
+ * constructor (it reserves no blocks until the first allocation), so equality never changes
+ * after construction. Moves copy the pool reference and leave the source usable.
+ *
+ * @tparam T The value type allocated.
+ */
+template <class T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = false_type;
+    using propagate_on_container_move_assignment = true_type;
+    using propagate_on_container_swap = true_type;
+
+    PoolAllocator() : pool(make_shared<NodePool>()) {}
+
+    PoolAllocator(const PoolAllocator&) noexcept = default;
+    PoolAllocator(PoolAllocator&& other) noexcept : pool(other.pool) {}
+    PoolAllocator& operator=(const PoolAllocator&) noexcept = default;
+    PoolAllocator& operator=(PoolAllocator&& other) noexcept
+    {
+        pool = other.pool;
+        return *this;
+    }
+
+    template <class U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : pool(other.pool) {}
+
+    T* allocate(size_t n)
+    {
+        static_assert(alignof(T) <= alignof(max_align_t), "PoolAllocator does not support over-aligned types");
+        if (n > size_t(-1) / sizeof(T))
+            throw bad_array_new_length();
+        return static_cast<T*>(pool->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept
+    {
+        pool->deallocate(ptr, n * sizeof(T));
+    }
+
+    /**
+     * @brief Gives a copied container its own arena instead of sharing the source's.
+     */
+    PoolAllocator select_on_container_copy_construction() const { return PoolAllocator(); }
+
+    /**
+     * @brief Frees the whole arena in one go if no other allocator shares it.
+     * @return True if the blocks were released, false if the pool is shared and nothing was done.
+     */
+    bool releaseAll() noexcept
+    {
+        if (pool.use_count() != 1)
+            return false;
+        pool->release();
+        return true;
+    }
+
+    /**
+     * @brief The pool backing this allocator, shared by all of its copies.
+     */
+    const NodePool* getPool() const { return pool.get(); }
+
+    template <class U> friend class PoolAllocator;
+
+    template <class U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept { return pool == other.pool; }
+
+    template <class U>
+    bool operator!=(const PoolAllocator<U>& other) const noexcept { return pool != other.pool; }
+
+private:
+    shared_ptr<NodePool> pool;
+};
@@ -0,0 +1,304 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include "SplayTraits.h"
+using namespace std;
+
+/**
+ * @brief An ordered set with O(1) point-in-time snapshots, built on path copying.
+ *
+ * The tree is a treap whose nodes are immutable once published and shared between versions
+ * through reference counts. An update copies only the O(log n) nodes on its search path and
+ * publishes a new root; every older Version keeps seeing exactly the nodes it started with.
+ * Nodes no version can reach any more are freed when the last Version holding them goes away.
+ *
+ * Thread safety: one writer at a time (insert_or_assign, erase, buildFrom); snapshot() and all
+ * Version members may be called from any thread, concurrently with the writer.
+ *
+ * @tparam T The data type stored in the tree.
+ * @tparam Traits Key extraction and comparison, as for SplayTree (see SplayTraits).
+ */
+template <class T, class Traits = SplayTraits<T>>
+class PersistentTree
+{
+private:
+    struct Node;
+    using NodePtr = shared_ptr<const Node>;
+
+public:
+    using key_type = typename Traits::key_type;
+
+    /**
+     * @brief A frozen version of the tree. Cheap to copy; keeps its nodes alive while it exists.
+     */
+    class Version
+    {
+    public:
+        Version() = default;
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        /**
+         * @brief Looks a key up in this version.
+         * @return Pointer to the value (valid as long as this Version lives), nullptr if absent.
+         */
+        const T* find(const key_type& key) const;
+
+        /**
+         * @brief Calls visit(const T&) for every value in ascending key order.
+         */
+        template <class Visit>
+        void forEach(Visit visit) const;
+
+    private:
+        friend class PersistentTree;
+        Version(NodePtr root, size_t count) : root(std::move(root)), count(count) {}
+
+        NodePtr root;
+        size_t count = 0;
+    };
+
+    PersistentTree() = default;
+    PersistentTree(const PersistentTree&) = delete;
+    PersistentTree& operator=(const PersistentTree&) = delete;
+
+    /**
+     * @brief The current version, in O(1).
+     */
+    Version snapshot() const;
+
+    /**
+     * @brief Inserts the value, or replaces the stored value with the same key.
+     * @return True if inserted, false if replaced.
+     */
+    bool insert_or_assign(const T& value);
+
+    /**
+     * @brief Removes the value with the key.
+     * @return False if no such value exists.
+     */
+    bool erase(const key_type& key);
+
+    /**
+     * @brief Replaces the contents with values sorted by strictly ascending key, in O(n).
+     */
+    void buildFrom(const vector<T>& sorted);
+
+    /**
+     * @brief Replaces the contents with count values read in strictly ascending key order from first, in O(n).
+     *        Reads straight out of another ordered container, e.g. a SplayTree's const iterators, without a copy.
+     */
+    template <class InputIt>
+    void buildFrom(InputIt first, size_t count);
+
+    size_t size() const { return snapshot().size(); }
+
+private:
+    struct Node
+    {
+        T data;
+        NodePtr left;
+        NodePtr right;
+        uint32_t priority; ///< Max-heap order; random, so the expected depth is O(log n).
+
+        Node(const T& data, NodePtr left, NodePtr right, uint32_t priority)
+            : data(data), left(std::move(left)), right(std::move(right)), priority(priority) {}
+    };
+
+    static int compareKey(const key_type& key, const T& data) { return Traits::compare(key, Traits::keyOf(data)); }
+
+    static NodePtr make(const T& data, NodePtr left, NodePtr right, uint32_t priority)
+    {
+        return make_shared<const Node>(data, std::move(left), std::move(right), priority);
+    }
+
+    NodePtr insert(const NodePtr& node, const T& value, uint32_t priority, bool& inserted);
+    NodePtr remove(const NodePtr& node, const key_type& key, bool& removed);
+    static NodePtr merge(const NodePtr& left, const NodePtr& right);
+    template <class InputIt>
+    static NodePtr build(InputIt& next, size_t count, uint32_t priority);
+
+    void publish(NodePtr root, size_t count);
+
+    mutable mutex lock;   ///< Guards root/count while they are published or read.
+    NodePtr root;
+    size_t count = 0;
+    mt19937 rng{ 5489u };
+};
+
+template <class T, class Traits>
+const T* PersistentTree<T, Traits>::Version::find(const key_type& key) const
+{
+    const Node* node = root.get();
+    while (node)
+    {
+        int cmp = compareKey(key, node->data);
+        if (cmp == 0)
+            return &node->data;
+        node = (cmp < 0) ? node->left.get() : node->right.get();
+    }
+    return nullptr;
+}
+
+template <class T, class Traits>
+template <class Visit>
+void PersistentTree<T, Traits>::Version::forEach(Visit visit) const
+{
+    // Explicit stack: nothing in a shared node can point back up
+    vector<const Node*> stack;
+    const Node* node = root.get();
+    while (node || !stack.empty())
+    {
+        while (node)
+        {
+            stack.push_back(node);
+            node = node->left.get();
+        }
+        node = stack.back();
+        stack.pop_back();
+        visit(node->data);
+        node = node->right.get();
+    }
+}
+
+template <class T, class Traits>
+typename PersistentTree<T, Traits>::Version PersistentTree<T, Traits>::snapshot() const
+{
+    lock_guard<mutex> guard(lock);
+    return Version(root, count);
+}
+
+template <class T, class Traits>
+void PersistentTree<T, Traits>::publish(NodePtr newRoot, size_t newCount)
+{
+    NodePtr old;
+    {
+        lock_guard<mutex> guard(lock);
+        old = std::move(root);
+        root = std::move(newRoot);
+        count = newCount;
+    }
+    // old is released here, outside the lock, freeing whatever no version still uses
+}
+
+template <class T, class Traits>
+bool PersistentTree<T, Traits>::insert_or_assign(const T& value)
+{
+    bool inserted = false;
+    NodePtr newRoot = insert(root, value, static_cast<uint32_t>(rng()), inserted);
+    publish(std::move(newRoot), count + (inserted ? 1 : 0));
+    return inserted;
+}
+
+template <class T, class Traits>
+bool PersistentTree<T, Traits>::erase(const key_type& key)
+{
+    bool removed = false;
+    NodePtr newRoot = remove(root, key, removed);
+    if (removed)
+        publish(std::move(newRoot), count - 1);
+    return removed;
+}
+
+template <class T, class Traits>
+void PersistentTree<T, Traits>::buildFrom(const vector<T>& sorted)
+{
+    buildFrom(sorted.begin(), sorted.size());
+}
+
+template <class T, class Traits>
+template <class InputIt>
+void PersistentTree<T, Traits>::buildFrom(InputIt first, size_t count)
+{
+    publish(build(first, count, UINT32_MAX), count);
+}
+
+/**
+ * @brief Path-copying treap insert: returns the root of a new subtree, node is left untouched
+ */
+template <class T, class Traits>
+typename PersistentTree<T, Traits>::NodePtr PersistentTree<T, Traits>::insert(const NodePtr& node, const T& value, uint32_t priority, bool& inserted)
+{
+    if (!node)
+    {
+        inserted = true;
+        return make(value, nullptr, nullptr, priority);
+    }
+
+    int cmp = compareKey(Traits::keyOf(value), node->data);
+    if (cmp == 0)
+        return make(value, node->left, node->right, node->priority); // Same shape, new value
+
+    if (cmp < 0)
+    {
+        NodePtr left = insert(node->left, value, priority, inserted);
+        if (left->priority > node->priority) // Rotate right to restore the heap order
+            return make(left->data, left->left, make(node->data, left->right, node->right, node->priority), left->priority);
+        return make(node->data, std::move(left), node->right, node->priority);
+    }
+
+    NodePtr right = insert(node->right, value, priority, inserted);
+    if (right->priority > node->priority) // Rotate left
+        return make(right->data, make(node->data, node->left, right->left, node->priority), right->right, right->priority);
+    return make(node->data, node->left, std::move(right), node->priority);
+}
+
+template <class T, class Traits>
+typename PersistentTree<T, Traits>::NodePtr PersistentTree<T, Traits>::remove(const NodePtr& node, const key_type& key, bool& removed)
+{
+    if (!node)
+        return nullptr;
+
+    int cmp = compareKey(key, node->data);
+    if (cmp == 0)
+    {
+        removed = true;
+        return merge(node->left, node->right);
+    }
+
+    if (cmp < 0)
+    {
+        NodePtr left = remove(node->left, key, removed);
+        return removed ? make(node->data, std::move(left), node->right, node->priority) : node;
+    }
+
+    NodePtr right = remove(node->right, key, removed);
+    return removed ? make(node->data, node->left, std::move(right), node->priority) : node;
+}
+
+/**
+ * @brief Joins two treaps whose keys are all smaller (left) / larger (right), copying only the merge spine
+ */
+template <class T, class Traits>
+typename PersistentTree<T, Traits>::NodePtr PersistentTree<T, Traits>::merge(const NodePtr& left, const NodePtr& right)
+{
+    if (!left) return right;
+    if (!right) return left;
+
+    if (left->priority > right->priority)
+        return make(left->data, left->left, merge(left->right, right), left->priority);
+    return make(right->data, merge(left, right->left), right->right, right->priority);
+}
+
+/**
+ * @brief Balanced build in key order, consuming count values from next; priorities fall with depth
+ *        so the heap order holds without rotations
+ */
+template <class T, class Traits>
+template <class InputIt>
+typename PersistentTree<T, Traits>::NodePtr PersistentTree<T, Traits>::build(InputIt& next, size_t count, uint32_t priority)
+{
+    if (count == 0)
+        return nullptr;
+
+    uint32_t childPriority = priority - (priority >> 4) - 1;
+    NodePtr left = build(next, count / 2, childPriority);
+    T value = *next; // Read before the right half advances the input
+    ++next;
+    NodePtr right = build(next, count - count / 2 - 1, childPriority);
+    return make(value, std::move(left), std::move(right), priority);
+}
@@ -0,0 +1,242 @@
+#pragma once
+#include <map>
+#include <vector>
+#include <cstddef>
+#include "SplayObserver.h"
+
+using namespace std;
+
+/**
+ * @brief One restructuring step of a recorded splay, by key instead of by node pointer.
+ *
+ * A Right or Left step rotates pivot above its parent. A TopDown step replaces the whole
+ * shape with the one listed in preorder (a preorder list determines a binary search tree).
+ */
+template <class Key>
+struct RotationStep
+{
+    RotationKind kind;
+    Key pivot;
+    size_t depth;         ///< As in RotationEvent.
+    vector<Key> preorder; ///< TopDown steps only.
+};
+
+/**
+ * @brief Shape of a binary search tree by key: links only, no payload.
+ *
+ * Holds a private copy of a tree's structure that a recorded trace can be replayed on at any
+ * pace, while the tree itself has long moved on. Subtree sizes are kept, so the in-order
+ * rank of a node (its column in a drawing) is found by walking up, and every node remembers
+ * the last step that rotated it, for telling hot parts of the tree from cold ones.
+ */
+template <class Key>
+class TreeShape
+{
+public:
+    struct Links
+    {
+        const Key* parent = nullptr;
+        const Key* left = nullptr;
+        const Key* right = nullptr;
+        size_t size = 1;    ///< Nodes in the subtree rooted here.
+        size_t touched = 0; ///< now() when the node last took part in a rotation, 0 if never.
+    };
+
+    void clear() { links.clear(); top = nullptr; }
+
+    bool empty() const { return top == nullptr; }
+    size_t size() const { return links.size(); }
+
+    const Key* root() const { return top; }
+    const Links& at(const Key& key) const { return links.at(key); }
+
+    size_t sizeOf(const Key* key) const { return key ? links.at(*key).size : 0; }
+
+    /**
+     * @brief Number of steps applied so far.
+     */
+    size_t now() const { return clock; }
+
+    /**
+     * @brief Distance of the node from the root, walking up.
+     */
+    size_t depthOf(const Key& key) const
+    {
+        size_t depth = 0;
+        for (const Key* up = links.at(key).parent; up; up = links.at(*up).parent)
+            depth++;
+        return depth;
+    }
+
+    /**
+     * @brief Number of keys smaller than the node's, from the subtree sizes on the way up.
+     */
+    size_t rankOf(const Key& key) const
+    {
+        auto found = links.find(key);
+        const Links* node = &found->second;
+        size_t rank = sizeOf(node->left);
+        for (const Key* at = &found->first; node->parent; )
+        {
+            const Links& parent = links.at(*node->parent);
+            if (parent.right == at)
+                rank += sizeOf(parent.left) + 1;
+            at = node->parent;
+            node = &parent;
+        }
+        return rank;
+    }
+
+    /**
+     * @brief Keys of a tree with parent links in preorder, listed without recursion.
+     * @param keyOf Returns the key of a node.
+     */
+    template <class Node, class KeyOf>
+    static vector<Key> preorderKeys(const Node* root, KeyOf keyOf)
+    {
+        vector<Key> keys;
+        for (const Node* node = root; node; node = nextPreorder(node))
+            keys.push_back(keyOf(node));
+        return keys;
+    }
+
+    /**
+     * @brief Copies the shape of a tree with parent links.
+     */
+    template <class Node, class KeyOf>
+    void capture(const Node* root, KeyOf keyOf) { assignPreorder(preorderKeys(root, keyOf)); }
+
+    /**
+     * @brief Rebuilds the shape from its keys in preorder.
+     */
+    void assignPreorder(const vector<Key>& preorder)
+    {
+        clear();
+        for (const Key& key : preorder)
+            insertLeaf(key);
+    }
+
+    /**
+     * @brief Applies one recorded step.
+     */
+    void apply(const RotationStep<Key>& step)
+    {
+        clock++;
+        if (step.kind == RotationKind::TopDown)
+            assignPreorder(step.preorder);
+        else
+            rotateUp(step.pivot);
+    }
+
+    /**
+     * @brief Rotates the node with the key above its parent; a no-op for the root or an unknown key.
+     */
+    void rotateUp(const Key& key)
+    {
+        auto found = links.find(key);
+        if (found == links.end() || !found->second.parent)
+            return;
+
+        const Key* pivot = &found->first;
+        Links& p = found->second;
+        const Key* parent = p.parent;
+        Links& q = links.at(*parent);
+        const Key* grand = q.parent;
+
+        if (q.left == pivot)
+        {
+            q.left = p.right;
+            if (p.right) links.at(*p.right).parent = parent;
+            p.right = parent;
+        }
+        else
+        {
+            q.right = p.left;
+            if (p.left) links.at(*p.left).parent = parent;
+            p.left = parent;
+        }
+        q.parent = pivot;
+        p.parent = grand;
+        q.size = 1 + sizeOf(q.left) + sizeOf(q.right);
+        p.size = 1 + sizeOf(p.left) + sizeOf(p.right);
+        p.touched = q.touched = clock;
+
+        if (!grand)
+            top = pivot;
+        else
+        {
+            Links& g = links.at(*grand);
+            (g.left == parent ? g.left : g.right) = pivot;
+        }
+    }
+
+private:
+    template <class Node>
+    static const Node* nextPreorder(const Node* node)
+    {
+        if (node->left) return node->left;
+        if (node->right) return node->right;
+        // Climb until a right sibling that has not been visited appears
+        while (node->parent && (node == node->parent->right || !node->parent->right))
+            node = node->parent;
+        return node->parent ? node->parent->right : nullptr;
+    }
+
+    void insertLeaf(const Key& key)
+    {
+        auto inserted = links.emplace(key, Links());
+        const Key* leaf = &inserted.first->first;
+        if (!top)
+        {
+            top = leaf;
+            return;
+        }
+
+        const Key* at = top;
+        for (;;)
+        {
+            Links& l = links.at(*at);
+            l.size++;
+            const Key*& child = key < *at ? l.left : l.right;
+            if (!child)
+            {
+                child = leaf;
+                inserted.first->second.parent = at;
+                return;
+            }
+            at = child;
+        }
+    }
+
+    map<Key, Links> links; ///< Node keys stay put in a map, so links can point at them.
+    const Key* top = nullptr;
+    size_t clock = 0;
+};
+
+/**
+ * @brief Observer that records a splay as key-based RotationSteps for later replay on a TreeShape.
+ *
+ * Select it through the traits, e.g.
+ * @code
+ * template <class Node> using observer = RotationTraceObserver<Node, AccountTraits>;
+ * @endcode
+ * Recording copies one key per rotation; a TopDown step lists the whole tree in preorder.
+ * @tparam KeyTraits Supplies key_type and keyOf(const T&), as SplayTraits does.
+ */
+template <class Node, class KeyTraits>
+struct RotationTraceObserver
+{
+    using Key = typename KeyTraits::key_type;
+
+    static constexpr bool enabled = true;
+
+    vector<RotationStep<Key>> steps;
+
+    void onRotation(const RotationEvent<Node>& event)
+    {
+        RotationStep<Key> step{ event.kind, KeyTraits::keyOf(event.pivot->data), event.depth, {} };
+        if (event.kind == RotationKind::TopDown)
+            step.preorder = TreeShape<Key>::preorderKeys(event.root, [](const Node* node) { return KeyTraits::keyOf(node->data); });
+        steps.push_back(std::move(step));
+    }
+};
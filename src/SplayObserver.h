@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Restructuring step reported to a SplayTree observer.
+ *
+ * Bottom-up splaying reports every single rotation: Right for zig() (the left child rises),
+ * Left for zag(). Top-down splaying takes the tree apart while descending, so it reports one
+ * TopDown step once the tree has been reassembled.
+ */
+enum class RotationKind
+{
+    Right,
+    Left,
+    TopDown
+};
+
+/**
+ * @brief One restructuring step of a SplayTree.
+ * @tparam Node The tree's node type (SplayTree::NodeType).
+ */
+template <class Node>
+struct RotationEvent
+{
+    RotationKind kind;
+    Node* pivot;       ///< The node that moved up; for TopDown the new root.
+    std::size_t depth; ///< Depth of pivot after the step (root = 0); for TopDown the depth it came from.
+    Node* root;        ///< Root of the tree after the step.
+};
+
+/**
+ * @brief Default observer: ignores every event. As enabled is false the tree never builds an
+ *        event, so an unobserved tree pays nothing per rotation.
+ */
+struct NullSplayObserver
+{
+    static constexpr bool enabled = false;
+
+    template <class Event>
+    void onRotation(const Event&) {}
+};
+
+/**
+ * @brief Observer that keeps every event and optionally forwards it to a listener as it happens.
+ *
+ * Select it through the traits, then reach it with SplayTree::observer():
+ * @code
+ * struct DemoTraits : AccountTraits { template <class Node> using observer = RecordingSplayObserver<Node>; };
+ * @endcode
+ * @warning The recorded pivot and root pointers are only valid while their nodes exist.
+ */
+template <class Node>
+struct RecordingSplayObserver
+{
+    static constexpr bool enabled = true;
+
+    std::vector<RotationEvent<Node>> events;
+    std::function<void(const RotationEvent<Node>&)> listener; ///< Called for each event, if set.
+    bool record = true; ///< Keep events in events; turn off when only the listener is wanted.
+
+    void onRotation(const RotationEvent<Node>& event)
+    {
+        if (record)
+            events.push_back(event);
+        if (listener)
+            listener(event);
+    }
+
+    void clear() { events.clear(); }
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Operation counters of a SplayTree whose traits set collectStats (see SplayTraits).
+ *
+ * Counted are the key comparisons of lookups, inserts and erases, the splay steps by kind and
+ * the single rotations they are made of, the hits and misses of lookups, and a histogram of the
+ * depth at which each access ended (the node found, or the last node visited on a miss).
+ * liveNodes and nodeBytes are filled in by SplayTree::stats() whether counting is on or not.
+ */
+struct SplayStats
+{
+    static constexpr std::size_t depthBuckets = 64; ///< Depths from 63 on share the last bucket.
+
+    std::uint64_t comparisons = 0;
+    std::uint64_t rotations = 0;   ///< Single rotations (zig() / zag() and top-down zig-zig rotations).
+    std::uint64_t zigSteps = 0;    ///< Steps with one rotation; top-down: links without a rotation.
+    std::uint64_t zigZigSteps = 0;
+    std::uint64_t zigZagSteps = 0; ///< Bottom-up only; top-down splaying does zig-zag as two links.
+    std::uint64_t hits = 0;        ///< Lookups (search, find, contains, peek) that found the key.
+    std::uint64_t misses = 0;
+    std::array<std::uint64_t, depthBuckets> accessDepth{}; ///< Accesses per depth, the root being depth 0.
+
+    std::size_t liveNodes = 0;
+    std::size_t nodeBytes = 0;     ///< liveNodes times the node size, without allocator overhead.
+
+    /**
+     * @brief Counts an access that ended at the given depth.
+     */
+    void recordDepth(std::size_t depth) { accessDepth[depth < depthBuckets ? depth : depthBuckets - 1]++; }
+};
+
+namespace splay_detail
+{
+    /**
+     * @brief Stands in for SplayStats in trees that do not count.
+     */
+    struct NoStats {};
+}
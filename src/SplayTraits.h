@@ -0,0 +1,135 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include "SplayObserver.h"
+
+/**
+ * @brief Selects how a SplayTree restructures itself on access.
+ *
+ * BottomUp descends first and then rotates the accessed node up through its parent links.
+ * TopDown (Sleator-Tarjan) splits the tree into left/right halves while descending, so the
+ * search and the restructuring happen in the same single pass.
+ */
+enum class SplayMode
+{
+    BottomUp,
+    TopDown
+};
+
+namespace splay_detail
+{
+    /**
+     * @brief Three-way comparison returning negative/zero/positive for less/equal/greater.
+     *
+     * Arithmetic keys are compared branch-free; any other type only needs operator<.
+     */
+    template <class K>
+    inline int threeWayCompare(const K& a, const K& b)
+    {
+        if constexpr (std::is_arithmetic<K>::value)
+            return (b < a) - (a < b);
+        else
+            return a < b ? -1 : (b < a ? 1 : 0);
+    }
+}
+
+/**
+ * @brief Compile-time policy bundle for SplayTree.
+ *
+ * Customize a tree by deriving from this struct and overriding members, e.g.
+ * @code
+ * struct MyTraits : SplayTraits<Account> { static constexpr SplayMode mode = SplayMode::TopDown; };
+ * SplayTree<Account, std::allocator<Account>, MyTraits> tree;
+ * @endcode
+ *
+ * The tree is ordered by keyOf(value) compared with compare(). By default the whole value is
+ * the key; overriding key_type and keyOf turns the tree into a map keyed by a member, so
+ * lookups can be made with a raw key and no temporary T (see AccountTraits).
+ *
+ * @tparam T The data type stored in the tree.
+ */
+template <class T>
+struct SplayTraits
+{
+    static constexpr SplayMode mode = SplayMode::BottomUp; ///< Splaying strategy.
+
+    static constexpr std::size_t parallelSortThreshold = 1 << 15; ///< Bulk loads at least this large sort in parallel.
+
+    static constexpr std::size_t parallelVisitThreshold = 1 << 14; ///< Trees at least this large are walked in parallel.
+
+    static constexpr bool orderStatistics = false; ///< Keep subtree sizes for rank(), select() and countInRange().
+
+    static constexpr bool collectStats = false; ///< Count comparisons, rotations and access depths (see SplayStats, StatsTraits).
+
+    /**
+     * @brief Receives a RotationEvent for every restructuring step, see SplayObserver.h.
+     *        The default ignores them and compiles away; RecordingSplayObserver keeps them.
+     */
+    template <class Node>
+    using observer = NullSplayObserver;
+
+    /**
+     * @brief Monoid summarised over every subtree for aggregate() and aggregateRange(); void for none.
+     *
+     * Traits that set it also provide
+     * @code
+     * static aggregate_type measure(const T& value);                                // Summary of one value
+     * static aggregate_type combine(const aggregate_type& a, const aggregate_type& b); // Associative, a before b
+     * @endcode
+     * and a default-constructed aggregate_type must be the identity of combine().
+     */
+    using aggregate_type = void;
+
+    using key_type = T; ///< Type the tree is ordered and searched by.
+
+    /**
+     * @brief Extracts the key of a stored value.
+     */
+    static const T& keyOf(const T& value) { return value; }
+
+    /**
+     * @brief Three-way key comparison, called once per visited node.
+     * @return Negative if a < b, zero if equal, positive if a > b.
+     */
+    template <class K>
+    static int compare(const K& a, const K& b) { return splay_detail::threeWayCompare(a, b); }
+};
+
+/**
+ * @brief Traits selecting single-pass top-down splaying, everything else as in SplayTraits<T>.
+ */
+template <class T>
+struct TopDownSplayTraits : SplayTraits<T>
+{
+    static constexpr SplayMode mode = SplayMode::TopDown;
+};
+
+/**
+ * @brief Adds subtree sizes to another set of traits, enabling rank(), select() and countInRange().
+ *
+ * Every node grows by one size_t and each rotation updates two counts.
+ * @code
+ * SplayTree<int, std::allocator<int>, OrderStatisticsTraits<TopDownSplayTraits<int>>> tree;
+ * @endcode
+ */
+template <class Base>
+struct OrderStatisticsTraits : Base
+{
+    static constexpr bool orderStatistics = true;
+};
+
+/**
+ * @brief Adds operation counters to another set of traits (see SplayStats).
+ *
+ * Off by default, as counting costs a few increments per access and the counters are written
+ * by the const lookups too (find, contains, peek). A counting tree must therefore not be read
+ * from several threads at once, even when no writer runs.
+ * @code
+ * SplayTree<Account, std::allocator<Account>, StatsTraits<AccountTraits>> tree;
+ * @endcode
+ */
+template <class Base>
+struct StatsTraits : Base
+{
+    static constexpr bool collectStats = true;
+};
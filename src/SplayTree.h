@@ -1,9 +1,243 @@
 #pragma once
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <iterator>
 #include <functional> 
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include "NodePool.h"
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include "SplayTraits.h"
+#include "SplayStats.h"
+#include "SplayObserver.h"
 using namespace std;
 
+namespace splay_detail
+{
+    /**
+     * @brief Detects allocators that can drop their whole arena at once (see PoolAllocator::releaseAll).
+     */
+    template <class A, class = void>
+    struct has_release_all : false_type {};
+
+    template <class A>
+    struct has_release_all<A, void_t<decltype(declval<A&>().releaseAll())>> : true_type {};
+
+    /**
+     * @brief Number of threads the parallel helpers use: the hardware threads, at most 16.
+     */
+    inline size_t parallelThreads()
+    {
+        size_t threads = thread::hardware_concurrency();
+        return threads > 16 ? 16 : (threads == 0 ? 1 : threads);
+    }
+
+    /**
+     * @brief parallelThreads() - 1 threads started once per process and reused by every parallel helper.
+     *
+     * run() lends them to one batch at a time. A batch started while another one is running (from
+     * another thread, or nested inside a job) does not wait for the pool: its caller does the
+     * whole batch alone.
+     */
+    class WorkerPool
+    {
+    public:
+        static WorkerPool& shared()
+        {
+            static WorkerPool pool(parallelThreads() - 1);
+            return pool;
+        }
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        ~WorkerPool()
+        {
+            {
+                lock_guard<mutex> guard(lock);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (thread& worker : workers)
+                worker.join();
+        }
+
+        /**
+         * @brief Calls work() on the calling thread and on up to helpers pool threads, and returns
+         *        once every call has returned.
+         * @param work Must not throw; a pool thread joining late may find nothing left to do.
+         */
+        void run(const function<void()>& work, size_t helpers)
+        {
+            if (helpers == 0 || workers.empty() || busy.exchange(true))
+            {
+                work();
+                return;
+            }
+
+            {
+                lock_guard<mutex> guard(lock);
+                task = &work;
+                claimed = 0;
+                wanted = helpers;
+                generation++;
+            }
+            wake.notify_all();
+            work();
+
+            unique_lock<mutex> guard(lock);
+            task = nullptr; // Threads that have not joined yet stay out
+            done.wait(guard, [this]() { return running == 0; });
+            guard.unlock();
+            busy = false;
+        }
+
+    private:
+        explicit WorkerPool(size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+                workers.emplace_back([this]() { serve(); });
+        }
+
+        void serve()
+        {
+            size_t seen = 0;
+            unique_lock<mutex> guard(lock);
+            for (;;)
+            {
+                wake.wait(guard, [&]() { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+                if (!task || claimed >= wanted)
+                    continue;
+
+                const function<void()>* work = task;
+                claimed++;
+                running++;
+                guard.unlock();
+                (*work)();
+                guard.lock();
+                if (--running == 0)
+                    done.notify_all();
+            }
+        }
+
+        vector<thread> workers;
+        atomic<bool> busy{ false };  ///< Set while a batch owns the pool.
+        mutex lock;                  ///< Guards everything below.
+        condition_variable wake;     ///< A batch was posted, or the pool is stopping.
+        condition_variable done;     ///< The last running pool thread returned from the batch.
+        const function<void()>* task = nullptr;
+        size_t generation = 0;
+        size_t claimed = 0;
+        size_t wanted = 0;
+        size_t running = 0;
+        bool stopping = false;
+    };
+
+    /**
+     * @brief Runs job(i) for every i in [0, count) on the calling thread and the shared WorkerPool.
+     *
+     * Threads claim the next index from a shared counter, so a thread that finishes early keeps
+     * taking work from the others. The first exception thrown by a job is rethrown after all
+     * threads have stopped; the remaining indices are then skipped.
+     */
+    template <class Job>
+    void parallelFor(size_t count, Job job)
+    {
+        atomic<size_t> next{ 0 };
+        atomic<bool> failed{ false };
+        exception_ptr error;
+
+        auto work = [&]() {
+            for (size_t i = next++; i < count && !failed; i = next++)
+            {
+                try
+                {
+                    job(i);
+                }
+                catch (...)
+                {
+                    if (!failed.exchange(true))
+                        error = current_exception();
+                }
+            }
+        };
+
+        WorkerPool::shared().run(work, count == 0 ? 0 : count - 1);
+
+        if (error)
+            rethrow_exception(error);
+    }
+
+    /**
+     * @brief Node base holding the subtree size when Traits::orderStatistics is set, empty otherwise.
+     */
+    template <bool Enabled>
+    struct SubtreeSize
+    {
+        size_t size = 1; ///< Number of nodes in the subtree rooted here.
+    };
+
+    template <>
+    struct SubtreeSize<false> {};
+
+    /**
+     * @brief Adds the subtree aggregate (Traits::aggregate_type) on top of SubtreeSize.
+     *        A single inheritance chain, so both collapse to nothing when unused, on MSVC too.
+     */
+    template <class Aggregate, bool Sized>
+    struct NodeAugments : SubtreeSize<Sized>
+    {
+        Aggregate aggregate{}; ///< Traits::combine over the subtree rooted here, in key order.
+    };
+
+    template <bool Sized>
+    struct NodeAugments<void, Sized> : SubtreeSize<Sized> {};
+
+    /**
+     * @brief Stable sort that sorts equal slices on separate threads and merges them pairwise.
+     *
+     * Runs on parallelFor, so it needs no parallel-algorithms backend (TBB) at link time.
+     * Falls back to a single std::stable_sort when only one hardware thread is available.
+     */
+    template <class It, class Less>
+    void parallelStableSort(It first, It last, Less less)
+    {
+        const size_t n = static_cast<size_t>(last - first);
+        const size_t parts = parallelThreads();
+        if (parts < 2 || n < parts * 2)
+        {
+            stable_sort(first, last, less);
+            return;
+        }
+
+        vector<It> bounds;
+        for (size_t i = 0; i <= parts; i++)
+            bounds.push_back(first + static_cast<ptrdiff_t>(n * i / parts));
+
+        parallelFor(parts, [&bounds, &less](size_t i) { stable_sort(bounds[i], bounds[i + 1], less); });
+
+        // Merge neighbouring runs until one is left; the merges of one round are independent
+        for (size_t width = 1; width < parts; width *= 2)
+        {
+            const size_t merges = (parts - width + 2 * width - 1) / (2 * width);
+            parallelFor(merges, [&bounds, &less, width, parts](size_t m) {
+                const size_t i = m * 2 * width;
+                inplace_merge(bounds[i], bounds[i + width], bounds[min(i + 2 * width, parts)], less);
+            });
+        }
+    }
+}
+
 /**
  * @brief A self-adjusting binary search tree called Splay Tree.
  *
@@ -11,27 +245,46 @@ using namespace std;
  * which helps to keep frequently accessed nodes near the top for faster access.
  *
  * @tparam T The data type of the elements stored in the tree.
+ * @tparam Allocator Allocator used for the nodes (rebound to the internal node type).
+ *         Use PoolAllocator for slab allocation or std::pmr::polymorphic_allocator for a memory resource.
+ * @tparam Traits Compile-time policies (see SplayTraits): bottom-up or top-down splaying,
+ *         the key extracted from each value and its three-way comparison.
  */
 
-template <class T>
+template <class T, class Allocator = std::allocator<T>, class Traits = SplayTraits<T>>
 class SplayTree
 {
 private:
     class Node; // <-- Forward declaration of Node
 public:
     using NodeType = Node; // Public alias for Node type
+    using allocator_type = Allocator;
+    using key_type = typename Traits::key_type; ///< Type the tree is ordered and searched by (see SplayTraits).
+    using aggregate_type = typename Traits::aggregate_type; ///< Subtree summary, void when not kept (see SplayTraits).
 
     /**
      * @brief Default constructor. Initializes an empty splay tree.
      */
     SplayTree();
 
+    /**
+     * @brief Constructs an empty tree drawing its nodes from the given allocator.
+     * @param alloc Allocator (or, for PmrSplayTree, a memory_resource pointer).
+     */
+    explicit SplayTree(const Allocator& alloc);
+
     /**
      * @brief Copy constructor.
      * @param other The SplayTree to copy from.
      */
     SplayTree(const SplayTree& other);
 
+    /**
+     * @brief Move constructor. Takes over the other tree's nodes in O(1); the other tree is left empty.
+     * @note The observer stays with the object it belongs to and is not transferred.
+     */
+    SplayTree(SplayTree&& other) noexcept;
+
     /**
      * @brief Destructor. Frees all allocated memory in the tree.
      */
@@ -44,6 +297,28 @@ public:
      */
     const SplayTree& operator=(const SplayTree& other);
 
+    /**
+     * @brief Move assignment. Steals the other tree's nodes in O(1) when the allocators allow it.
+     * @note The observer of this tree is kept.
+     */
+    SplayTree& operator=(SplayTree&& other) noexcept(allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+                                                     || allocator_traits<Allocator>::is_always_equal::value);
+
+    /**
+     * @brief Exchanges the contents of two trees in O(1).
+     */
+    void swap(SplayTree& other) noexcept;
+
+    /**
+     * @brief Removes every element. Pool-backed trees of trivially destructible data free their blocks in bulk.
+     */
+    void clear();
+
+    /**
+     * @brief Returns a copy of the allocator used by the tree.
+     */
+    allocator_type get_allocator() const { return allocator_type(nodeAlloc); }
+
     /**
      * @brief Display the tree in-order to the given output stream.
      * @param out Output stream to print the tree.
@@ -54,14 +329,85 @@ public:
      * @brief Inserts a new value into the splay tree and splays the newly inserted node to root.
      * @param value The value to insert.
      */
-    void insert(T value);
+    void insert(const T& value);
+
+    /**
+     * @brief Inserts a value by moving it into the new node.
+     * @param value The value to insert.
+     */
+    void insert(T&& value);
+
+    /**
+     * @brief Constructs a value in place from the arguments and inserts it.
+     * @return The node holding the value with that key, and whether it was inserted.
+     * @note The node is built before the lookup, so a duplicate costs one construction that is then discarded.
+     */
+    template <class... Args>
+    pair<Node*, bool> emplace(Args&&... args);
+
+    /**
+     * @brief Inserts a value constructed from the arguments only if no element with the key exists.
+     * @param key Key used for the lookup; nothing is constructed when it is already present.
+     * @return The node holding the key, and whether it was inserted.
+     */
+    template <class... Args>
+    pair<Node*, bool> try_emplace(const key_type& key, Args&&... args);
+
+    /**
+     * @brief Inserts the value, or overwrites the existing element with an equal key.
+     * @return The node holding the value, and true if it was inserted, false if assigned.
+     */
+    template <class V>
+    pair<Node*, bool> insert_or_assign(V&& value);
+
+    /**
+     * @brief Replaces the contents with the values of a range, building a perfectly balanced tree in O(n).
+     * @param values Any range of T, sorted or not. Passing a vector<T> rvalue moves the values into the nodes.
+     * @note Unsorted input is sorted first (in parallel above Traits::parallelSortThreshold). Of several
+     *       values with the same key only the first is kept, as with repeated insert().
+     */
+    template <class Range>
+    void buildFrom(Range&& values);
+
+    /**
+     * @brief Adds the values of a range to the tree in one pass. Existing elements win over equal keys.
+     * @param values Any range of T, sorted or not.
+     * @details A small batch is inserted one by one; a large one is merged with the in-order node
+     *          sequence and the tree is relinked balanced in O(n + m). Existing nodes are reused.
+     */
+    template <class Range>
+    void mergeFrom(Range&& values);
 
     /**
-     * @brief Removes a value from the splay tree if it exists.
-     * @param value The value to remove.
+     * @brief Removes the element with the given key from the splay tree if it exists.
+     * @param key The key of the value to remove.
      * @return True if element is deleted
      */
-    bool erase(T value);
+    bool erase(const key_type& key);
+
+    /**
+     * @brief Removes every element with a key in [lo, hi].
+     * @return Number of elements removed.
+     * @details Two splays cut the range out as one subtree and the remaining halves are joined
+     *          again, so restructuring costs amortized O(log n); freeing the k removed nodes adds O(k).
+     */
+    size_t eraseRange(const key_type& lo, const key_type& hi);
+
+    /**
+     * @brief Moves every element with a key not less than key into a new tree.
+     * @return The tree of the larger keys; this tree keeps the smaller ones.
+     * @details Nodes are relinked, not copied, and the new tree shares this tree's allocator.
+     *          Amortized O(log n) plus counting the smaller of the two halves.
+     */
+    SplayTree split(const key_type& key);
+
+    /**
+     * @brief Moves every element of other into this tree, leaving other empty.
+     * @details When all keys of other lie above (or below) all keys of this tree and both trees
+     *          share an allocator, the trees are linked with one splay in amortized O(log n).
+     *          Otherwise the elements are moved over as with mergeFrom, and existing keys win.
+     */
+    void join(SplayTree& other);
 
     /**
      * @brief Checks whether the tree is empty.
@@ -70,18 +416,171 @@ public:
     bool empty() const;
 
     /**
-     * @brief Searches for a value in the tree and splays the node to root if found.
-     * @param value The value to search for.
+     * @brief Searches for a key in the tree and splays the node to root if found.
+     * @param key The key to search for, e.g. a customer ID for an AccountTree.
      * @return Pointer to the node containing the value, or nullptr if not found.
      */
-    Node* search(T data);
+    Node* search(const key_type& key);
 
     /**
-    * @brief Searches for a value in the tree and splays the node to root if found.
-    * @param ID. The ID of the desired Data
-    * @return Pointer to the node containing the value, or nullptr if not found.
-    */
-    Node* search(int id);
+     * @brief Looks a key up without restructuring the tree.
+     * @param key The key to search for.
+     * @return Pointer to the node containing the value, or nullptr if not found.
+     * @note Never rotates, so concurrent const readers are safe as long as no writer runs.
+     */
+    const Node* find(const key_type& key) const { return searchNoSplay(key); }
+    Node* find(const key_type& key) { return searchNoSplay(key); }
+
+    /**
+     * @brief Checks whether an element with the key exists, without restructuring the tree.
+     */
+    bool contains(const key_type& key) const { return searchNoSplay(key) != nullptr; }
+
+    /**
+     * @brief Returns the stored value for the key without restructuring the tree.
+     * @return Pointer to the value, or nullptr if not found.
+     */
+    const T* peek(const key_type& key) const;
+    T* peek(const key_type& key);
+
+    /**
+     * @brief Bidirectional in-order iterator, stepping along the parent links.
+     *
+     * An iterator points at a node, and rotations move nodes without reallocating them, so it
+     * stays valid across splays. It is invalidated only when its node is erased, or by clear(),
+     * assignment and buildFrom(). end() can be decremented to reach the largest element.
+     * @warning Changing the key of a value through a mutable iterator breaks the tree order.
+     */
+    template <bool Const>
+    class Iterator
+    {
+    public:
+        using iterator_category = bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = conditional_t<Const, const T*, T*>;
+        using reference = conditional_t<Const, const T&, T&>;
+
+        Iterator() = default;
+
+        /// A mutable iterator converts to a const one.
+        template <bool C = Const, class = enable_if_t<C>>
+        Iterator(const Iterator<false>& other) : node(other.node), tree(other.tree) {}
+
+        reference operator*() const { return node->data; }
+        pointer operator->() const { return &node->data; }
+
+        Iterator& operator++() { node = nextNode(node); return *this; }
+        Iterator operator++(int) { Iterator old = *this; ++*this; return old; }
+        Iterator& operator--() { node = node ? prevNode(node) : tree->lastNode(); return *this; }
+        Iterator operator--(int) { Iterator old = *this; --*this; return old; }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.node == b.node; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.node != b.node; }
+
+    private:
+        friend class SplayTree;
+        template <bool> friend class Iterator;
+
+        Iterator(Node* node, const SplayTree* tree) : node(node), tree(tree) {}
+
+        Node* node = nullptr;             ///< nullptr for end().
+        const SplayTree* tree = nullptr;  ///< Needed to step back from end().
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    iterator begin() { return iterator(firstNode(), this); }
+    iterator end() { return iterator(nullptr, this); }
+    const_iterator begin() const { return const_iterator(firstNode(), this); }
+    const_iterator end() const { return const_iterator(nullptr, this); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    /**
+     * @brief First element whose key is not less than key, or end().
+     * @param splayResult Splay the element found to the root, as search() would.
+     */
+    iterator lower_bound(const key_type& key, bool splayResult = false);
+    const_iterator lower_bound(const key_type& key) const { return const_iterator(lowerBoundNode(key, false), this); }
+
+    /**
+     * @brief First element whose key is greater than key, or end().
+     * @param splayResult Splay the element found to the root, as search() would.
+     */
+    iterator upper_bound(const key_type& key, bool splayResult = false);
+    const_iterator upper_bound(const key_type& key) const { return const_iterator(lowerBoundNode(key, true), this); }
+
+    /**
+     * @brief The elements with the key: an empty range at lower_bound if there is none, otherwise one element.
+     * @param splayResult Splay the element found to the root.
+     */
+    pair<iterator, iterator> equal_range(const key_type& key, bool splayResult = false);
+    pair<const_iterator, const_iterator> equal_range(const key_type& key) const;
+
+    /**
+     * @brief Number of elements with a key less than key, i.e. the index key has or would have in order.
+     * @note Requires Traits::orderStatistics (see OrderStatisticsTraits). Does not restructure the tree.
+     */
+    size_t rank(const key_type& key) const;
+
+    /**
+     * @brief The element at index k in key order (0 is the smallest), or end() if k >= size.
+     * @param splayResult Splay the element found to the root.
+     * @note Requires Traits::orderStatistics.
+     */
+    iterator select(size_t k, bool splayResult = false);
+    const_iterator select(size_t k) const { return const_iterator(selectNode(k), this); }
+
+    /**
+     * @brief Number of elements with a key in [lo, hi], in two descents.
+     * @note Requires Traits::orderStatistics.
+     */
+    size_t countInRange(const key_type& lo, const key_type& hi) const;
+
+    /**
+     * @brief Traits::combine over every element, read off the root in O(1).
+     * @note Requires Traits::aggregate_type.
+     */
+    aggregate_type aggregate() const;
+
+    /**
+     * @brief Traits::combine over the elements with a key in [lo, hi], in key order.
+     * @details Whole subtrees inside the range contribute their stored aggregate, so only the two
+     *          boundary paths are walked. Does not restructure the tree.
+     * @note Requires Traits::aggregate_type.
+     */
+    aggregate_type aggregateRange(const key_type& lo, const key_type& hi) const;
+
+    /**
+     * @brief Brings the aggregates of the node and its ancestors up to date.
+     * @note Call after changing a value in place (through a Node*, peek() or a mutable iterator);
+     *       the operations of the tree itself keep the aggregates current.
+     */
+    void refreshAugments(Node* node);
+    void refreshAugments(iterator it) { refreshAugments(it.node); }
+
+    /**
+     * @brief Calls visit(const T&) for every element, on several threads for large trees.
+     * @details The tree is cut into a few dozen disjoint key ranges of similar size that the threads
+     *          claim one by one (see splay_detail::parallelFor); the cut uses the subtree sizes when
+     *          Traits::orderStatistics is set. Nothing is splayed, so the walk is safe as long as no
+     *          writer runs at the same time. Trees below Traits::parallelVisitThreshold are walked serially.
+     * @note visit is called concurrently and in no particular order; it must be thread-safe.
+     */
+    template <class Visit>
+    void parallelForEach(Visit visit) const;
+
+    /**
+     * @brief Folds map(const T&) over every element with combine, on several threads for large trees.
+     * @param identity Neutral element of combine; each thread starts from it.
+     * @param map Turns an element into an R.
+     * @param combine Associative; it need not be commutative, as partial results are combined in key order.
+     * @return identity combined with every mapped element in key order.
+     */
+    template <class R, class Map, class Combine>
+    R parallelReduce(R identity, Map map, Combine combine) const;
 
 
     /*
@@ -91,9 +590,25 @@ public:
     int nodeCount() const;
     /*
  * @brief Helps determin the tree height and confirm that the splaying minimizes the tree height.
- * @return The height of the tree ranges from 0~inf
+ * @return Number of levels of the subtree: 0 when empty, 1 for a single node
+ * @note Walks the parent links with O(1) extra space, so even a degenerate chain cannot overflow the stack.
  */
     int height(Node* node) const;
+    int height() const { return height(root); }
+
+    /**
+     * @brief Histogram of node depths over every stride-th node in key order; index 0 counts the root.
+     * @details A stride above 1 samples the tree; the walk itself still steps over every node, without recursion.
+     */
+    vector<size_t> depthProfile(size_t stride = 1) const;
+
+    /**
+     * @brief Operation counters since construction or the last resetStats(), with the live node count and bytes.
+     * @note The counters stay zero unless Traits::collectStats is set. A counting tree also counts its const
+     *       lookups, so concurrent readers of such a tree need to be serialized.
+     */
+    SplayStats stats() const;
+    void resetStats();
 
     Node* getRoot() const { return root; }
 
@@ -101,17 +616,25 @@ public:
 
     inline T getRootValue() const { return root->data; }
 
-    vector<T> collectInOrder(vector<T>&) const;
+    /**
+     * @brief Appends every value to result in key order.
+     * @return result, for chaining.
+     */
+    vector<T>& collectInOrder(vector<T>& result) const;
 
-    std::function<void(NodeType* root)> onRotationCallback;
+    using observer_type = typename Traits::template observer<Node>; ///< Receives every RotationEvent (see SplayTraits).
 
-    void setOnRotationCallback(std::function<void(NodeType* root)> callback);
+    /**
+     * @brief The observer instance of this tree, e.g. to attach a listener to a RecordingSplayObserver.
+     */
+    observer_type& observer() { return rotationObserver; }
+    const observer_type& observer() const { return rotationObserver; }
 
 private:
     /**
      * @brief A node of the splay tree containing data and left/right child pointers.
      */
-    class Node
+    class Node : public splay_detail::NodeAugments<typename Traits::aggregate_type, Traits::orderStatistics>
     {
     public:
         T data;          ///< Value stored in the node.
@@ -121,11 +644,22 @@ private:
 
         /**
          * @brief Node constructor.
-         * @param val The value to store in the node.
+         * @param args Arguments forwarded to the constructor of the stored value.
          */
-        Node(const T& val) : data(val), left(nullptr), right(nullptr), parent(nullptr) {}
+        template <class... Args>
+        explicit Node(Args&&... args) : data(std::forward<Args>(args)...), left(nullptr), right(nullptr), parent(nullptr) {}
     };
 
+    using NodeAllocator = typename allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeAllocTraits = allocator_traits<NodeAllocator>;
+
+    NodeAllocator nodeAlloc; ///< Allocator the nodes are drawn from.
+
+    observer_type rotationObserver; ///< Told about every rotation, unless observer_type::enabled is false.
+
+    /// Operation counters; an empty placeholder unless Traits::collectStats is set.
+    mutable conditional_t<Traits::collectStats, SplayStats, splay_detail::NoStats> counters;
+
     Node* root; ///< Pointer to the root node of the tree.
 
     int nodecount = 0; /// Tracks the nodes' count of the tree.
@@ -140,17 +674,50 @@ private:
     /**
      * @brief Performs a right rotation on the given node pointer.
      * @param node Reference to the pointer of the node to rotate.
+     * @param pivotDepth Depth of node's left child after the rotation, reported to the observer.
      */
-    void zig(Node* node);
+    void zig(Node* node, size_t pivotDepth);
 
     /**
      * @brief Performs a left rotation on the given node pointer.
      * @param node Reference to the pointer of the node to rotate.
+     * @param pivotDepth Depth of node's right child after the rotation, reported to the observer.
+     */
+    void zag(Node* node, size_t pivotDepth);
+
+    static constexpr bool observed = observer_type::enabled;
+
+    /**
+     * @brief Single-pass top-down splay (Sleator-Tarjan). Restructures the tree while descending
+     *        toward a key and leaves the last node on the search path at the root.
+     * @param cmp Callable returning negative/zero/positive when the key is less than/equal to/greater than a node's data.
+     * @return The result of comparing the key with the new root's data.
+     * @warning The tree must not be empty.
+     */
+    template <class Cmp>
+    int splayTopDown(Cmp cmp);
+
+    /**
+     * @brief Three-way comparison of a key against the key of a stored value, through Traits.
      */
-    void zag(Node* node);
+    static int compareKey(const key_type& key, const T& data) { return Traits::compare(key, Traits::keyOf(data)); }
 
     /**
-     * @brief Recursively deletes all nodes in the tree starting from the given node.
+     * @brief Counts a descent that compared the key with `compared` nodes, ending at depth compared - 1.
+     *        Like countLookup, compiles to nothing unless Traits::collectStats is set.
+     */
+    void countDescent(size_t compared) const;
+    void countLookup(bool hit) const;
+
+    /**
+     * @brief Calls visit(node, depth) for every node of the subtree in key order, depth relative to node.
+     *        Follows the parent links, so it needs no stack.
+     */
+    template <class Visit>
+    static void walkDepths(Node* node, Visit visit);
+
+    /**
+     * @brief Deletes all nodes in the tree starting from the given node.
      * @param node The starting node for deletion.
      */
     void destroyTree(Node* node);
@@ -166,86 +733,283 @@ private:
     void preorder(Node* node, ostream&) const;
 
 
-    /*
-     * @brief returns a pointer to the predecessor of a Node (Tarek Mohamed)
-     * @return Node* to the pred of the node of T data. if not found returns its expected location.
-     * @note This is a helper function used in erase function to find pred in case data not found
+    Node* searchNoSplay(const key_type& key) const;
+
+    /**
+     * @brief Shared insertion path: locates the key described by cmp and, if absent, links the node from make().
+     * @param cmp Three-way comparison of the key against a node's data.
+     * @param make Callable returning a freshly created node; only invoked when the key is absent.
+     * @return The node holding the key (now at the root), and whether make() was used.
      */
-    Node* findPred(T data) const;
+    template <class Cmp, class Make>
+    pair<Node*, bool> insertWith(Cmp cmp, Make make);
 
-    Node* searchNoSplay(T data) const;
+    /**
+     * @brief Copies or moves a range into a vector sorted by key with duplicate keys removed (first one kept).
+     */
+    template <class Range>
+    static vector<T> sortedBatch(Range&& values);
 
-    Node* copyTree(Node* source, Node* parent);
+    /**
+     * @brief Appends the tree's nodes to out in key order, following parent links (no recursion).
+     */
+    void collectNodes(vector<Node*>& out) const;
 
-    void leafNodesHelper(ostream& out, Node* ptr) const;
+    /**
+     * @brief In-order neighbours through the parent links; nullptr past either end.
+     */
+    static Node* nextNode(Node* node);
+    static Node* prevNode(Node* node);
+    static Node* leftmost(Node* node);
+    static Node* rightmost(Node* node);
 
-    void collectInOrderHelper(Node*, vector<T>& result) const;
+    Node* firstNode() const;
+    Node* lastNode() const;
 
-};
+    /**
+     * @brief Descent to the first node whose key is not less than key (strict: greater than key).
+     */
+    Node* lowerBoundNode(const key_type& key, bool strict) const;
 
+    /**
+     * @brief A unit of parallel work: the nodes from first to last in key order.
+     */
+    struct VisitTask
+    {
+        Node* first;
+        Node* last;
+        size_t count; ///< Number of nodes, 0 while not known yet.
+    };
 
-/**
- * @brief Overloads the << operator to print the tree.
- * @tparam T data type stored in the tree. Can be in our case a "BankAccount" class.
- * @param out Output stream.
- * @param tree The splay tree to print.
- * @return Reference to the output stream.
- */
-template <class T>
-ostream& operator<<(ostream& out, const SplayTree<T>& tree);
+    /**
+     * @brief Cuts the tree into in-order tasks of at most about nodeCount() / wanted nodes each.
+     */
+    vector<VisitTask> splitForVisit(size_t wanted) const;
 
-/**
- * @brief Overloads the >> operator to read elements into the tree.
- * @tparam T data type stored in the tree. Can be in our case a "BankAccount" class.
- * @param in Input stream.
- * @param tree The splay tree to modify.
- * @return Reference to the input stream.
- */
-template <class T>
-istream& operator>>(istream& in, SplayTree<T>& tree);
+    /**
+     * @brief splitForVisit without subtree sizes: breadth-first expansion, then oversized tasks are measured and cut.
+     */
+    vector<VisitTask> splitUnsizedForVisit(size_t wanted, size_t limit) const;
 
-/**
- * @brief Default constructor - initializes empty Splay Tree
- * @tparam T Data type stored in tree
- * @post root set to nullptr
- * @author Kerolos Ayman
- */
-template<class T>
-SplayTree<T>::SplayTree() : root(nullptr) {}
+    /**
+     * @brief Calls fn(const T&) for the task's elements in key order.
+     */
+    template <class Fn>
+    static void visitTask(const VisitTask& task, Fn& fn);
+
+    static constexpr bool hasAggregate = !is_void<aggregate_type>::value;
+    static constexpr bool augmented = Traits::orderStatistics || hasAggregate;
+
+    /**
+     * @brief Recomputes the subtree size and aggregate of a node from its children.
+     *        A no-op unless Traits::orderStatistics or Traits::aggregate_type is set.
+     */
+    static void updateAugments(Node* node);
+    static size_t sizeOf(const Node* node);
+
+    /**
+     * @brief Number of keys less than key (strict: not greater than key).
+     */
+    size_t rankOf(const key_type& key, bool strict) const;
+    Node* selectNode(size_t k) const;
+
+    /**
+     * @brief Makes the root of the tree built from two detached subtrees, all keys of lower below those of upper.
+     */
+    void joinNodes(Node* lower, Node* upper);
+
+    /**
+     * @brief Destroys a detached subtree without recursion.
+     * @return Number of nodes destroyed.
+     */
+    size_t destroySubtree(Node* node);
+
+    /**
+     * @brief Links a key-ordered node sequence into a balanced subtree.
+     * @return Root of the subtree built from nodes[lo, hi).
+     */
+    static Node* linkBalanced(Node* const* nodes, size_t lo, size_t hi, Node* parent);
+
+    Node* copyTree(Node* source, Node* parent);
+
+    /**
+     * @brief Allocates and constructs a node through the node allocator.
+     */
+    template <class... Args>
+    Node* createNode(Args&&... args);
+
+    /**
+     * @brief Destroys and deallocates a single node through the node allocator.
+     */
+    void destroyNode(Node* node);
+
+    void leafNodesHelper(ostream& out, Node* ptr) const;
+
+};
+
+/**
+ * @brief Splay tree whose nodes come from a per-tree slab arena (see NodePool).
+ */
+template <class T, class Traits = SplayTraits<T>>
+using PooledSplayTree = SplayTree<T, PoolAllocator<T>, Traits>;
+
+/**
+ * @brief Splay tree whose nodes come from a std::pmr::memory_resource supplied at construction.
+ */
+template <class T, class Traits = SplayTraits<T>>
+using PmrSplayTree = SplayTree<T, std::pmr::polymorphic_allocator<T>, Traits>;
+
+
+/**
+ * @brief Overloads the << operator to print the tree.
+ * @tparam T data type stored in the tree. Can be in our case a "BankAccount" class.
+ * @param out Output stream.
+ * @param tree The splay tree to print.
+ * @return Reference to the output stream.
+ */
+template <class T, class Allocator, class Traits>
+ostream& operator<<(ostream& out, const SplayTree<T, Allocator, Traits>& tree);
+
+/**
+ * @brief Overloads the >> operator to read elements into the tree.
+ * @tparam T data type stored in the tree. Can be in our case a "BankAccount" class.
+ * @param in Input stream.
+ * @param tree The splay tree to modify.
+ * @return Reference to the input stream.
+ */
+template <class T, class Allocator, class Traits>
+istream& operator>>(istream& in, SplayTree<T, Allocator, Traits>& tree);
+
+/**
+ * @brief Default constructor - initializes empty Splay Tree
+ * @tparam T Data type stored in tree
+ * @post root set to nullptr
+ * @author Kerolos Ayman
+ */
+template<class T, class Allocator, class Traits>
+SplayTree<T, Allocator, Traits>::SplayTree() : nodeAlloc(), root(nullptr) {}
+
+/**
+ * @brief Allocator-aware constructor - initializes empty Splay Tree using the given allocator
+ * @tparam T Data type stored in tree
+ * @param alloc Allocator the nodes will be drawn from
+ * @post root set to nullptr
+ */
+template<class T, class Allocator, class Traits>
+SplayTree<T, Allocator, Traits>::SplayTree(const Allocator& alloc) : nodeAlloc(alloc), root(nullptr) {}
 
 /**
  * @brief Copy constructor - creates deep copy of another Splay Tree
  * @tparam T Data type stored in tree
  * @param other Tree to copy from
  * @post New independent tree created with identical structure
+ * @note The allocator is obtained through select_on_container_copy_construction,
+ *       so a pool-backed tree gets a pool of its own.
  * @author Kerolos Ayman
  */
-template<class T>
-SplayTree<T>::SplayTree(const SplayTree<T>& other)
-    : root(nullptr), nodecount(other.nodecount) {
+template<class T, class Allocator, class Traits>
+SplayTree<T, Allocator, Traits>::SplayTree(const SplayTree<T, Allocator, Traits>& other)
+    : nodeAlloc(NodeAllocTraits::select_on_container_copy_construction(other.nodeAlloc)),
+      root(nullptr), nodecount(other.nodecount) {
     if (other.root) {
         root = copyTree(other.root, nullptr);
     }
 }
 
 /**
- * @brief Recursive helper for deep copying tree nodes
+ * @brief Helper for deep copying tree nodes
  * @tparam T Data type stored in tree
  * @param source Node to copy from
  * @param parent Parent node for new node
  * @return Node* Newly created node
+ * @details Walks the source and the copy in lockstep along their parent links, so no
+ *          recursion or stack is needed and a degenerate chain copies like any other tree.
+ *          A node's augments are computed once both of its children are copied.
  * @author Kerolos Ayman
  */
-template<class T>
-typename SplayTree<T>::Node* SplayTree<T>::copyTree(Node* source, Node* parent) {
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::Node* SplayTree<T, Allocator, Traits>::copyTree(Node* source, Node* parent) {
     if (!source) return nullptr;
 
-    Node* newNode = new Node(source->data);
-    newNode->parent = parent;
-    newNode->left = copyTree(source->left, newNode);
-    newNode->right = copyTree(source->right, newNode);
+    Node* newRoot = createNode(source->data);
+    newRoot->parent = parent;
+    try {
+        Node* from = source;
+        Node* to = newRoot;
+        for (;;) {
+            if (from->left && !to->left) {
+                to->left = createNode(from->left->data);
+                to->left->parent = to;
+                from = from->left;
+                to = to->left;
+            }
+            else if (from->right && !to->right) {
+                to->right = createNode(from->right->data);
+                to->right->parent = to;
+                from = from->right;
+                to = to->right;
+            }
+            else {
+                // Both children copied: finish this node and go back up
+                updateAugments(to);
+                if (from == source)
+                    break;
+                from = from->parent;
+                to = to->parent;
+            }
+        }
+    }
+    catch (...) {
+        destroyTree(newRoot); // Free the partial copy before propagating
+        throw;
+    }
+
+    return newRoot;
+}
+
+/**
+ * @brief Allocates a node through the node allocator and constructs the value in place
+ * @tparam T Data type stored in tree
+ * @param args Arguments forwarded to T's constructor
+ * @return Node* Newly created, unlinked node
+ * @throws std::bad_alloc if the allocator cannot provide memory
+ */
+template<class T, class Allocator, class Traits>
+template<class... Args>
+typename SplayTree<T, Allocator, Traits>::Node* SplayTree<T, Allocator, Traits>::createNode(Args&&... args) {
+    Node* node = NodeAllocTraits::allocate(nodeAlloc, 1);
+    try {
+        NodeAllocTraits::construct(nodeAlloc, node, std::forward<Args>(args)...);
+    }
+    catch (...) {
+        NodeAllocTraits::deallocate(nodeAlloc, node, 1);
+        throw;
+    }
+    return node;
+}
+
+/**
+ * @brief Destroys a single node and gives its memory back to the node allocator
+ * @tparam T Data type stored in tree
+ * @param node Node to release; its links are not followed
+ */
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::destroyNode(Node* node) {
+    NodeAllocTraits::destroy(nodeAlloc, node);
+    NodeAllocTraits::deallocate(nodeAlloc, node, 1);
+}
 
-    return newNode;
+/**
+ * @brief Move constructor - takes ownership of another tree's nodes
+ * @tparam T Data type stored in tree
+ * @param other Tree to move from; left empty but usable
+ * @post O(1), no node is copied or allocated
+ */
+template<class T, class Allocator, class Traits>
+SplayTree<T, Allocator, Traits>::SplayTree(SplayTree<T, Allocator, Traits>&& other) noexcept
+    : nodeAlloc(std::move(other.nodeAlloc)), root(other.root), nodecount(other.nodecount) {
+    other.root = nullptr;
+    other.nodecount = 0;
 }
 
 /**
@@ -254,56 +1018,120 @@ typename SplayTree<T>::Node* SplayTree<T>::copyTree(Node* source, Node* parent)
  * @post All memory freed, root set to nullptr
  * @author Kerolos Ayman
  */
-template<class T>
-SplayTree<T>::~SplayTree() {
-    destroyTree(root);
+template<class T, class Allocator, class Traits>
+SplayTree<T, Allocator, Traits>::~SplayTree() {
+    clear();
 }
 
 /**
- * @brief Recursively deletes all nodes in the tree starting from the given node.
+ * @brief Removes every node from the tree
+ * @tparam T Data type stored in tree
+ * @post root set to nullptr and node count reset to 0
+ * @details When the node allocator can release its arena wholesale (PoolAllocator not shared
+ *          with any other tree) and the nodes need no destructor, the blocks are dropped in one
+ *          call instead of walking the tree node by node.
+ */
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::clear() {
+    bool released = false;
+    if constexpr (splay_detail::has_release_all<NodeAllocator>::value && is_trivially_destructible<Node>::value) {
+        released = nodeAlloc.releaseAll();
+    }
+    if (!released)
+        destroyTree(root);
+    root = nullptr;
+    nodecount = 0;
+}
+
+/**
+ * @brief Deletes all nodes in the tree starting from the given node.
  * @tparam T Data type stored in the tree.
  * @param node Pointer to the current node to delete.
  * @post All nodes below and including the given node are deallocated.
  *        Used internally by the destructor to free memory.
+ * @note Iterative (see destroySubtree), so even a chain of millions of nodes is freed without recursion.
  * @author Kerolos Ayman
  */
-template<class T>
-void SplayTree<T>::destroyTree(Node* node) {
-    if (node) {
-        destroyTree(node->left);
-        destroyTree(node->right);
-        node->left = node->right = nullptr;
-        delete node;
-    }
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::destroyTree(Node* node) {
+    destroySubtree(node);
 }
 
 /**
  * @brief Copy assignment operator - replaces tree with deep copy
  * @tparam T Data type stored in tree
  * @param other Tree to copy from
- * @return const SplayTree<T>& Reference to modified tree
+ * @return const SplayTree<T, Allocator, Traits>& Reference to modified tree
  * @note Handles self-assignment safely
  * @author Kerolos Ayman
  */
-template<class T>
-const SplayTree<T>& SplayTree<T>::operator=(const SplayTree<T>& other) {
+template<class T, class Allocator, class Traits>
+const SplayTree<T, Allocator, Traits>& SplayTree<T, Allocator, Traits>::operator=(const SplayTree<T, Allocator, Traits>& other) {
     if (this != &other) {
-        destroyTree(root);
-        root = nullptr;
-        nodecount = other.nodecount;
+        clear();
+        if (other.root) {
+            root = copyTree(other.root, nullptr);
+            nodecount = other.nodecount;
+        }
+    }
+    return *this;
+}
+
+/**
+ * @brief Move assignment operator - replaces the contents with another tree's nodes
+ * @tparam T Data type stored in tree
+ * @param other Tree to move from; left empty but usable
+ * @return SplayTree<T, Allocator, Traits>& Reference to modified tree
+ * @details O(1) when the allocator propagates on move or both allocators compare equal.
+ *          Otherwise the nodes belong to a different memory source and are copied element-wise.
+ */
+template<class T, class Allocator, class Traits>
+SplayTree<T, Allocator, Traits>& SplayTree<T, Allocator, Traits>::operator=(SplayTree<T, Allocator, Traits>&& other)
+    noexcept(allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+             || allocator_traits<Allocator>::is_always_equal::value) {
+    if (this == &other)
+        return *this;
+
+    clear();
+    if constexpr (NodeAllocTraits::propagate_on_container_move_assignment::value) {
+        nodeAlloc = std::move(other.nodeAlloc);
+    }
+    else if (!(nodeAlloc == other.nodeAlloc)) {
         if (other.root) {
             root = copyTree(other.root, nullptr);
+            nodecount = other.nodecount;
         }
+        other.clear();
+        return *this;
     }
+
+    root = other.root;
+    nodecount = other.nodecount;
+    other.root = nullptr;
+    other.nodecount = 0;
     return *this;
 }
 
+/**
+ * @brief Exchanges the nodes (and, if the allocator propagates on swap, the allocators) of two trees
+ * @tparam T Data type stored in tree
+ * @param other Tree to swap with
+ */
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::swap(SplayTree<T, Allocator, Traits>& other) noexcept {
+    using std::swap;
+    if constexpr (NodeAllocTraits::propagate_on_container_swap::value) {
+        swap(nodeAlloc, other.nodeAlloc);
+    }
+    swap(root, other.root);
+    swap(nodecount, other.nodecount);
+}
+
 
 /**
  * @brief Inserts a new node with the given data into the Splay Tree
  * @tparam T Data type stored in the tree (must support comparison operators)
  * @param data The value to insert into the tree
- * @return true if insertion succeeded, false if duplicate found
  * @author Tarek Mohamed
  *
  * @details This implementation:
@@ -311,309 +1139,1475 @@ const SplayTree<T>& SplayTree<T>::operator=(const SplayTree<T>& other) {
  * 2. Splays the newly inserted node to root
  * 3. Maintains tree balance through splay operations
  *
+ * In SplayMode::TopDown the tree is splayed around the value in one descent and the
+ * new node is placed at the root between the two halves.
+ *
  * @note Duplicate values are not allowed in the tree
  * @warning This operation modifies the tree structure
  */
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::insert(const T& data)
+{
+    try
+    {
+        insertWith([&data](const T& other) { return compareKey(Traits::keyOf(data), other); },
+                   [this, &data]() { return createNode(data); });
+    }
+    catch (const bad_alloc&)
+    {
+        cerr << "ERROR:: Memory allocation failed during insert\n";
+    }
+}
 
-template<class T>
-void SplayTree<T>::insert(T data)
+/**
+ * @brief Inserts a value into the Splay Tree, moving it into the new node
+ * @tparam T Data type stored in the tree (must support comparison operators)
+ * @param data The value to insert; left untouched if an equal value already exists
+ */
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::insert(T&& data)
 {
-    Node* newNode = new(nothrow) Node(data);
-    if (!newNode)
+    try
+    {
+        insertWith([&data](const T& other) { return compareKey(Traits::keyOf(data), other); },
+                   [this, &data]() { return createNode(std::move(data)); });
+    }
+    catch (const bad_alloc&)
     {
         cerr << "ERROR:: Memory allocation failed during insert\n";
-        return;
     }
+}
+
+/**
+ * @brief Constructs a value in place and inserts it unless an equal value exists
+ * @tparam T Data type stored in the tree (must support comparison operators)
+ * @param args Arguments forwarded to T's constructor
+ * @return pair of the node holding the key (splayed to root) and true if the new value was inserted
+ * @throws std::bad_alloc if the node cannot be allocated
+ */
+template<class T, class Allocator, class Traits>
+template<class... Args>
+pair<typename SplayTree<T, Allocator, Traits>::Node*, bool> SplayTree<T, Allocator, Traits>::emplace(Args&&... args)
+{
+    Node* newNode = createNode(std::forward<Args>(args)...);
+    const T& data = newNode->data;
+    pair<Node*, bool> result;
+    try
+    {
+        result = insertWith([&data](const T& other) { return compareKey(Traits::keyOf(data), other); },
+                            [newNode]() { return newNode; });
+    }
+    catch (...)
+    {
+        destroyNode(newNode);
+        throw;
+    }
+
+    if (!result.second)
+        destroyNode(newNode); // Duplicate, discard the constructed value
+    return result;
+}
+
+/**
+ * @brief Inserts a value constructed from args only if no value with the given key exists
+ * @tparam T Data type stored in the tree (must support comparison operators)
+ * @param key Key looked up in the tree; must equal the key of the value args construct
+ * @param args Arguments forwarded to T's constructor, only used when the key is absent
+ * @return pair of the node holding the key (splayed to root) and true if a value was inserted
+ * @throws std::bad_alloc if the node cannot be allocated
+ */
+template<class T, class Allocator, class Traits>
+template<class... Args>
+pair<typename SplayTree<T, Allocator, Traits>::Node*, bool> SplayTree<T, Allocator, Traits>::try_emplace(const key_type& key, Args&&... args)
+{
+    return insertWith([&key](const T& other) { return compareKey(key, other); },
+                      [&]() { return createNode(std::forward<Args>(args)...); });
+}
+
+/**
+ * @brief Inserts a value or overwrites the stored value that compares equal to it
+ * @tparam T Data type stored in the tree (must support comparison operators)
+ * @param value Value to insert or assign (copied or moved depending on its value category)
+ * @return pair of the node holding the value (splayed to root) and true if inserted, false if assigned
+ * @throws std::bad_alloc if the node cannot be allocated
+ */
+template<class T, class Allocator, class Traits>
+template<class V>
+pair<typename SplayTree<T, Allocator, Traits>::Node*, bool> SplayTree<T, Allocator, Traits>::insert_or_assign(V&& value)
+{
+    pair<Node*, bool> result = insertWith([&value](const T& other) { return compareKey(Traits::keyOf(value), other); },
+                                          [&]() { return createNode(std::forward<V>(value)); });
+    if (!result.second)
+    {
+        result.first->data = std::forward<V>(value);
+        updateAugments(result.first); // The node is the root, nothing above it to refresh
+    }
+    return result;
+}
 
+/**
+ * @brief Common insertion path for insert, emplace, try_emplace and insert_or_assign
+ * @tparam T Data type stored in the tree
+ * @param cmp Three-way comparison of the key being inserted against a node's data
+ * @param make Returns the node to link; called only when the key is absent
+ * @return pair of the node holding the key (now the root) and whether make() was linked
+ *
+ * @details BottomUp: descends to the key or the insertion point, links the new node as a
+ * leaf and splays it (or splays the existing node). TopDown: splays around the key in one
+ * pass and places the new node at the root between the two halves.
+ * If make() throws, no node is linked and the node count is unchanged.
+ */
+template<class T, class Allocator, class Traits>
+template<class Cmp, class Make>
+pair<typename SplayTree<T, Allocator, Traits>::Node*, bool> SplayTree<T, Allocator, Traits>::insertWith(Cmp cmp, Make make)
+{
     if (root == nullptr)
     {
+        root = make();
+        updateAugments(root); // A lone node still has to measure its own value
+        nodecount++;
+        return { root, true };
+    }
+
+    if constexpr (Traits::mode == SplayMode::TopDown)
+    {
+        int result = splayTopDown(cmp);
+        if (result == 0) // Avoid duplicates, the existing node is already at the root
+            return { root, false };
+
+        Node* newNode = make();
+
+        // The new node becomes the root, taking the splayed root as one child
+        if (result < 0)
+        {
+            newNode->left = root->left;
+            newNode->right = root;
+            root->left = nullptr;
+        }
+        else
+        {
+            newNode->right = root->right;
+            newNode->left = root;
+            root->right = nullptr;
+        }
+        if (newNode->left) newNode->left->parent = newNode;
+        if (newNode->right) newNode->right->parent = newNode;
+        updateAugments(root);
+        updateAugments(newNode);
+
         root = newNode;
         nodecount++;
-        return;
+        return { root, true };
+    }
+    else
+    {
+        Node* tempPtr = root;
+        Node* predPtr = nullptr;
+        int result = 0;
+        size_t compared = 0;
+
+        while (tempPtr)
+        {
+            result = cmp(tempPtr->data);
+            compared++;
+            if (result == 0) // Avoid duplicates
+            {
+                countDescent(compared);
+                splay(tempPtr); // Still splay the found node to root
+                return { root, false };
+            }
+
+            predPtr = tempPtr;
+            tempPtr = (result < 0) ? tempPtr->left : tempPtr->right;
+        }
+        countDescent(compared);
+
+        Node* newNode = make();
+        nodecount++;
+        newNode->parent = predPtr;
+        if (result < 0)
+            predPtr->left = newNode;
+        else
+            predPtr->right = newNode;
+
+        splay(newNode); // Bring the new node to root
+        return { root, true };
+    }
+}
+
+
+/**
+ * @brief Replaces the tree's contents with the values of a range
+ * @tparam T Data type stored in the tree
+ * @param values Range of T, in any order
+ * @details Sorts the batch by key (skipped when already ascending), drops duplicate keys and
+ *          links the nodes as a perfectly balanced tree, so no splaying or rotation happens.
+ * @throws std::bad_alloc if a node cannot be allocated; the tree is then left empty
+ */
+template<class T, class Allocator, class Traits>
+template<class Range>
+void SplayTree<T, Allocator, Traits>::buildFrom(Range&& values)
+{
+    vector<T> batch = sortedBatch(std::forward<Range>(values));
+    clear();
+
+    vector<Node*> nodes;
+    nodes.reserve(batch.size());
+    try
+    {
+        for (T& value : batch)
+            nodes.push_back(createNode(std::move(value)));
+    }
+    catch (...)
+    {
+        for (Node* node : nodes)
+            destroyNode(node);
+        throw;
     }
 
-    Node* tempPtr = root;
-    Node* predPtr = nullptr;
+    root = linkBalanced(nodes.data(), 0, nodes.size(), nullptr);
+    nodecount = static_cast<int>(nodes.size());
+}
+
+/**
+ * @brief Adds a batch of values to the tree
+ * @tparam T Data type stored in the tree
+ * @param values Range of T, in any order
+ * @details When m * log2(n) < n for a batch of m values and a tree of n nodes, the values are
+ *          inserted one by one. Otherwise the batch is merged with the in-order node sequence
+ *          and the whole tree is relinked balanced in O(n + m). Either way every node is
+ *          allocated before the tree is touched.
+ * @throws std::bad_alloc if a node cannot be allocated; the tree is then unchanged
+ */
+template<class T, class Allocator, class Traits>
+template<class Range>
+void SplayTree<T, Allocator, Traits>::mergeFrom(Range&& values)
+{
+    if (!root)
+    {
+        buildFrom(std::forward<Range>(values));
+        return;
+    }
 
-    while (tempPtr)
+    vector<T> batch = sortedBatch(std::forward<Range>(values));
+    size_t n = static_cast<size_t>(nodecount);
+    size_t logN = 0;
+    while ((size_t(1) << logN) < n) logN++;
+    if (batch.size() * logN < n)
     {
-        if (data == tempPtr->data) // Avoid duplicates
+        // Allocate first, so a bad_alloc cannot leave part of the batch inserted; the few nodes
+        // whose key turns out to be taken are freed again
+        vector<Node*> fresh;
+        fresh.reserve(batch.size());
+        try
         {
-            delete newNode; // Prevent memory leak
-            splay(tempPtr); // Still splay the found node to root
-            nodecount++;
-            return;
+            for (T& value : batch)
+                fresh.push_back(createNode(std::move(value)));
+        }
+        catch (...)
+        {
+            for (Node* node : fresh)
+                destroyNode(node);
+            throw;
         }
 
-        predPtr = tempPtr;
-        if (data < tempPtr->data)
+        for (Node* node : fresh)
         {
-            tempPtr = tempPtr->left;
+            bool linked = insertWith([node](const T& other) { return compareKey(Traits::keyOf(node->data), other); },
+                                     [node]() { return node; }).second;
+            if (!linked)
+                destroyNode(node);
         }
-        else
+        return;
+    }
+
+    vector<Node*> existing;
+    existing.reserve(n);
+    collectNodes(existing);
+
+    vector<Node*> merged;
+    vector<Node*> created;
+    merged.reserve(n + batch.size());
+    created.reserve(batch.size());
+    try
+    {
+        auto it = existing.begin();
+        for (T& value : batch)
         {
-            tempPtr = tempPtr->right;
+            int cmp = 1;
+            while (it != existing.end() && (cmp = compareKey(Traits::keyOf(value), (*it)->data)) > 0)
+                merged.push_back(*it++);
+
+            if (it != existing.end() && cmp == 0)
+                continue; // Key already present, the existing element wins
+
+            created.push_back(createNode(std::move(value)));
+            merged.push_back(created.back());
         }
+        merged.insert(merged.end(), it, existing.end());
     }
-    nodecount++;    // incrementing nodecount here
-    newNode->parent = predPtr;
-    if (data < predPtr->data)
+    catch (...)
     {
-        predPtr->left = newNode;
+        // Nothing is relinked yet, so only the fresh nodes have to go
+        for (Node* node : created)
+            destroyNode(node);
+        throw;
     }
+
+    root = linkBalanced(merged.data(), 0, merged.size(), nullptr);
+    nodecount += static_cast<int>(created.size());
+}
+
+/**
+ * @brief Turns a range into a key-sorted, duplicate-free batch for the bulk operations
+ * @tparam T Data type stored in the tree
+ * @param values Range of T; a vector<T> rvalue is taken over without copying
+ * @return The values ordered by key, keeping the first of equal keys
+ */
+template<class T, class Allocator, class Traits>
+template<class Range>
+vector<T> SplayTree<T, Allocator, Traits>::sortedBatch(Range&& values)
+{
+    vector<T> batch;
+    if constexpr (is_same<decay_t<Range>, vector<T>>::value && !is_lvalue_reference<Range>::value)
+        batch = std::move(values);
     else
+        batch.assign(std::begin(values), std::end(values));
+
+    auto less = [](const T& a, const T& b) { return Traits::compare(Traits::keyOf(a), Traits::keyOf(b)) < 0; };
+    if (adjacent_find(batch.begin(), batch.end(), [&less](const T& a, const T& b) { return !less(a, b); }) == batch.end())
+        return batch; // Already strictly ascending, nothing to sort or drop
+
+    if (batch.size() >= Traits::parallelSortThreshold)
+        splay_detail::parallelStableSort(batch.begin(), batch.end(), less);
+    else
+        stable_sort(batch.begin(), batch.end(), less);
+
+    auto sameKey = [](const T& a, const T& b) { return Traits::compare(Traits::keyOf(a), Traits::keyOf(b)) == 0; };
+    batch.erase(unique(batch.begin(), batch.end(), sameKey), batch.end());
+    return batch;
+}
+
+/**
+ * @brief Collects the nodes in key order by walking successor links
+ * @tparam T Data type stored in the tree
+ * @param out Receives the node pointers, smallest key first
+ */
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::collectNodes(vector<Node*>& out) const
+{
+    for (Node* node = firstNode(); node; node = nextNode(node))
+        out.push_back(node);
+}
+
+/**
+ * @brief In-order successor: leftmost node of the right subtree, else the first ancestor reached from its left
+ * @tparam T Data type stored in the tree
+ * @return The next node in key order, nullptr after the largest
+ */
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::Node* SplayTree<T, Allocator, Traits>::nextNode(Node* node)
+{
+    if (node->right)
+    {
+        node = node->right;
+        while (node->left)
+            node = node->left;
+        return node;
+    }
+    while (node->parent && node == node->parent->right)
+        node = node->parent;
+    return node->parent;
+}
+
+/**
+ * @brief In-order predecessor, the mirror image of nextNode
+ * @tparam T Data type stored in the tree
+ * @return The previous node in key order, nullptr before the smallest
+ */
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::Node* SplayTree<T, Allocator, Traits>::prevNode(Node* node)
+{
+    if (node->left)
     {
-        predPtr->right = newNode;
+        node = node->left;
+        while (node->right)
+            node = node->right;
+        return node;
     }
+    while (node->parent && node == node->parent->left)
+        node = node->parent;
+    return node->parent;
+}
+
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::Node* SplayTree<T, Allocator, Traits>::leftmost(Node* node)
+{
+    while (node && node->left)
+        node = node->left;
+    return node;
+}
+
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::Node* SplayTree<T, Allocator, Traits>::rightmost(Node* node)
+{
+    while (node && node->right)
+        node = node->right;
+    return node;
+}
 
-    splay(newNode); // Bring the new node to root
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::Node* SplayTree<T, Allocator, Traits>::firstNode() const
+{
+    return leftmost(root);
 }
 
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::Node* SplayTree<T, Allocator, Traits>::lastNode() const
+{
+    Node* node = root;
+    while (node && node->right)
+        node = node->right;
+    return node;
+}
 
 /**
- * @brief Searches for a node containing the specified data and splays it to root
- * @tparam T Data type stored in the tree (must support comparison operators)
- * @param data The value to search for
- * @return true if found, false otherwise
+ * @brief Links nodes[lo, hi) into a balanced subtree rooted at the middle element
+ * @tparam T Data type stored in the tree
+ * @param nodes Nodes in key order
+ * @param parent Parent of the subtree root
+ * @return The subtree root, nullptr for an empty range
+ * @note Recursion depth is log2 of the range length
+ */
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::Node* SplayTree<T, Allocator, Traits>::linkBalanced(Node* const* nodes, size_t lo, size_t hi, Node* parent)
+{
+    if (lo >= hi) return nullptr;
+
+    size_t mid = lo + (hi - lo) / 2;
+    Node* node = nodes[mid];
+    node->parent = parent;
+    node->left = linkBalanced(nodes, lo, mid, node);
+    node->right = linkBalanced(nodes, mid + 1, hi, node);
+    updateAugments(node);
+    return node;
+}
+
+
+/**
+ * @brief Searches for a node with the specified key and splays it to root
+ * @tparam T Data type stored in the tree
+ * @param key The key to search for (Traits::key_type, e.g. a customer ID)
+ * @return Pointer to the found node (now the root), nullptr otherwise
  * @author Tarek Mohamed
  *
  * @details This implementation:
- * 1. Performs standard BST search
+ * 1. Performs standard BST search, one Traits::compare per visited node
  * 2. Splays the found node (or last accessed node) to root
  * 3. Maintains the splay tree's self-adjusting property
  *
  * @note The tree structure is modified during search to bring the found node to root
- * @warning Empty trees will return false without modification
+ * @warning Empty trees will return nullptr without modification
+ *
+ */
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::Node* SplayTree<T, Allocator, Traits>::search(const key_type& key)
+{
+    if constexpr (Traits::mode == SplayMode::TopDown)
+    {
+        if (!root) return nullptr;
+        int cmp = splayTopDown([&key](const T& other) { return compareKey(key, other); });
+        countLookup(cmp == 0);
+        return cmp == 0 ? root : nullptr;
+    }
+
+    Node* temp = root;
+    Node* pred = nullptr;
+    size_t compared = 0;
+
+    while (temp)
+    {
+        int cmp = compareKey(key, temp->data);
+        compared++;
+        if (cmp == 0)
+        {
+            countDescent(compared);
+            countLookup(true);
+            splay(temp);
+            return root;
+        }
+
+        pred = temp;
+        temp = (cmp < 0) ? temp->left : temp->right;
+    }
+
+    countDescent(compared);
+    countLookup(false);
+    if (pred)
+        splay(pred);
+
+    return nullptr; // not found
+}
+
+
+
+/*
+ * @brief Splaying brings node to the root and make it the new root and preserves the BST structure (Tarek Mohamed)
+ * @tparam T data type stored in the tree. Can be in our case a "BankAccount" class.
+ * @param Node* node - The node which becomes the new root
+ * @author Tarek Mohamed
+ */
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::splay(Node* node)
+{
+    // Depth of node, only measured for an observer; unobserved rotations ignore the depths passed
+    size_t depth = 0;
+    if constexpr (observed)
+        for (Node* up = node; up != root; up = up->parent)
+            depth++;
+
+    while (node != root)
+    {
+        Node* parent = node->parent;
+        if (parent == root)
+        {
+            if constexpr (Traits::collectStats) counters.zigSteps++;
+            if (node == parent->left)
+                zig(parent, 0);
+            else
+                zag(parent, 0);
+            depth = 0;
+        }
+        else
+        {
+            Node* grandParent = parent->parent;
+            if constexpr (Traits::collectStats)
+            {
+                if ((node == parent->left) == (parent == grandParent->left))
+                    counters.zigZigSteps++;
+                else
+                    counters.zigZagSteps++;
+            }
+            const size_t up = observed ? depth - 2 : 0; // Where node ends up
+            if (node == parent->left)
+            {
+                if (parent == grandParent->left)
+                {
+                    zig(grandParent, up);
+                    zig(parent, up);
+                }
+                else
+                {
+                    zig(parent, up + 1);
+                    zag(grandParent, up);
+                }
+            }
+            else
+            {
+                if (parent == grandParent->left)
+                {
+                    zag(parent, up + 1);
+                    zig(grandParent, up);
+                }
+                else
+                {
+                    zag(grandParent, up);
+                    zag(parent, up);
+                }
+            }
+            depth = up;
+        }
+    }
+}
+
+/*
+ * @brief Performs node right rotation
+ * @tparam T data type stored in the tree. Can be in our case a "BankAccount" class.
+ * @param Node* node - The node which becomes the rotation is performed on.
+ * @author Tarek Mohamed
+ */
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::zig(Node* node, size_t pivotDepth)
+{
+    Node* temp = node->left;
+    node->left = temp->right;
+    if (temp->right)
+        temp->right->parent = node;
+
+    temp->parent = node->parent;
+    if (!node->parent)
+        root = temp;
+    else if (node == node->parent->left)
+        node->parent->left = temp;
+    else // case node is the right child of its parent
+        node->parent->right = temp;
+
+    temp->right = node;
+    node->parent = temp;
+    updateAugments(node);
+    updateAugments(temp);
+    if constexpr (Traits::collectStats) counters.rotations++;
+
+    if constexpr (observed) rotationObserver.onRotation(RotationEvent<Node>{ RotationKind::Right, temp, pivotDepth, root });
+}
+
+/*
+ * @brief Performs node left rotation
+ * @tparam T data type stored in the tree. Can be in our case a "BankAccount" class.
+ * @param Node* node - The node which becomes the rotation is performed on.
+ * @author Tarek Mohamed
+ */
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::zag(Node* node, size_t pivotDepth)
+{
+    Node* temp = node->right;
+    node->right = temp->left;
+
+    if (temp->left)
+        temp->left->parent = node;
+
+    temp->parent = node->parent;
+
+    if (!node->parent)
+        root = temp;
+    else if (node == node->parent->left)
+        node->parent->left = temp;
+    else
+        node->parent->right = temp;
+
+    temp->left = node;
+    node->parent = temp;
+    updateAugments(node);
+    updateAugments(temp);
+    if constexpr (Traits::collectStats) counters.rotations++;
+
+    if constexpr (observed) rotationObserver.onRotation(RotationEvent<Node>{ RotationKind::Left, temp, pivotDepth, root });
+}
+
+/**
+ * @brief Top-down splay: brings the node matching the key (or the last node on its search path) to the root in one descent
+ * @tparam T data type stored in the tree. Can be in our case a "BankAccount" class.
+ * @param cmp Three-way comparison of the searched key against a node's data
+ * @return Comparison of the key against the new root (0 means found)
+ *
+ * @details While descending, nodes smaller than the key are hung off the right spine of a
+ * "left tree" and nodes larger than the key off the left spine of a "right tree"; a zig-zig
+ * or zag-zag step rotates first. At the end the two trees are reassembled under the final node.
+ * Every node on the path is compared exactly once. Parent links are kept up to date so the
+ * rest of the tree (bottom-up helpers, traversal, the demo renderer) keeps working unchanged.
+ *
+ * @note The observer gets one TopDown event, after the tree has been reassembled.
+ */
+template<class T, class Allocator, class Traits>
+template<class Cmp>
+int SplayTree<T, Allocator, Traits>::splayTopDown(Cmp compareWith)
+{
+    auto cmp = [this, &compareWith](const T& data) {
+        if constexpr (Traits::collectStats) counters.comparisons++;
+        return compareWith(data);
+    };
+    size_t links = 0;           // Nodes moved into the side trees
+    size_t rotated = 0;         // Of those, the ones rotated first (zig-zig / zag-zag)
+
+    Node* t = root;
+    Node* leftRoot = nullptr;   // Nodes known to be smaller than the key
+    Node* leftMax = nullptr;    // Right-most node of that tree, where the next one hangs
+    Node* rightRoot = nullptr;  // Nodes known to be larger than the key
+    Node* rightMin = nullptr;   // Left-most node of that tree
+    bool restructured = false;
+
+    int result = cmp(t->data);
+    while (result != 0)
+    {
+        if (result < 0)
+        {
+            Node* child = t->left;
+            if (!child) break;
+            int childResult = cmp(child->data);
+
+            if (childResult < 0 && child->left)
+            {
+                // zig-zig: rotate right before linking
+                rotated++;
+                t->left = child->right;
+                if (child->right) child->right->parent = t;
+                child->right = t;
+                t->parent = child;
+                updateAugments(t);
+                t = child;
+                child = t->left;
+                childResult = cmp(child->data);
+            }
+
+            // Link t into the right tree as its new minimum
+            if (rightMin) { rightMin->left = t; t->parent = rightMin; }
+            else rightRoot = t;
+            rightMin = t;
+
+            t = child;
+            result = childResult;
+        }
+        else
+        {
+            Node* child = t->right;
+            if (!child) break;
+            int childResult = cmp(child->data);
+
+            if (childResult > 0 && child->right)
+            {
+                // zag-zag: rotate left before linking
+                rotated++;
+                t->right = child->left;
+                if (child->left) child->left->parent = t;
+                child->left = t;
+                t->parent = child;
+                updateAugments(t);
+                t = child;
+                child = t->right;
+                childResult = cmp(child->data);
+            }
+
+            // Link t into the left tree as its new maximum
+            if (leftMax) { leftMax->right = t; t->parent = leftMax; }
+            else leftRoot = t;
+            leftMax = t;
+
+            t = child;
+            result = childResult;
+        }
+        links++;
+        restructured = true;
+    }
+
+    if constexpr (Traits::collectStats)
+    {
+        counters.rotations += rotated;
+        counters.zigZigSteps += rotated;
+        counters.zigSteps += links - rotated;
+        counters.recordDepth(links + rotated); // Each link descends one level, each rotation one more
+    }
+
+    // Reassemble: t's subtrees go to the inner spines, the side trees become t's children
+    if (leftMax)
+    {
+        leftMax->right = t->left;
+        if (t->left) t->left->parent = leftMax;
+        t->left = leftRoot;
+        leftRoot->parent = t;
+    }
+    if (rightMin)
+    {
+        rightMin->left = t->right;
+        if (t->right) t->right->parent = rightMin;
+        t->right = rightRoot;
+        rightRoot->parent = t;
+    }
+    t->parent = nullptr;
+    root = t;
+
+    if constexpr (augmented)
+    {
+        // The nodes linked into the side trees hang off their inner spines, deepest first
+        for (Node* node = leftMax; node && node != t; node = node->parent)
+            updateAugments(node);
+        for (Node* node = rightMin; node && node != t; node = node->parent)
+            updateAugments(node);
+        updateAugments(t);
+    }
+
+    if constexpr (observed)
+        if (restructured) rotationObserver.onRotation(RotationEvent<Node>{ RotationKind::TopDown, root, links + rotated, root });
+    return result;
+}
+
+/**
+ * @brief Plain BST descent to the node with the key; the tree is left as it is
+ * @tparam T Data type stored in the tree
+ * @param key The key to search for
+ * @return The node holding the key, nullptr if absent
+ */
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::Node* SplayTree<T, Allocator, Traits>::searchNoSplay(const key_type& key) const
+{
+    Node* temp = root;
+    size_t compared = 0;
+
+    while (temp)
+    {
+        int cmp = compareKey(key, temp->data);
+        compared++;
+        if (cmp == 0)
+        {
+            countDescent(compared);
+            countLookup(true);
+            return temp;
+        }
+
+        temp = (cmp < 0) ? temp->left : temp->right;
+    }
+
+    countDescent(compared);
+    countLookup(false);
+    return nullptr; // not found
+}
+
+/**
+ * @brief Read-only lookup of a stored value
+ * @tparam T Data type stored in the tree
+ * @param key The key to search for
+ * @return Pointer to the value, or nullptr if absent
+ * @note Unlike search(), a miss does not splay the last visited node either
+ */
+template<class T, class Allocator, class Traits>
+const T* SplayTree<T, Allocator, Traits>::peek(const key_type& key) const
+{
+    const Node* node = searchNoSplay(key);
+    return node ? &node->data : nullptr;
+}
+
+template<class T, class Allocator, class Traits>
+T* SplayTree<T, Allocator, Traits>::peek(const key_type& key)
+{
+    Node* node = searchNoSplay(key);
+    return node ? &node->data : nullptr;
+}
+
+/**
+ * @brief Plain BST descent remembering the last node where the search turned left
+ * @tparam T Data type stored in the tree
+ * @param key The key to bound
+ * @param strict False for the first key >= key (lower bound), true for the first key > key (upper bound)
+ * @return The bounding node, nullptr if every key is smaller
+ */
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::Node* SplayTree<T, Allocator, Traits>::lowerBoundNode(const key_type& key, bool strict) const
+{
+    Node* temp = root;
+    Node* bound = nullptr;
+
+    while (temp)
+    {
+        int cmp = compareKey(key, temp->data);
+        if (cmp < 0 || (cmp == 0 && !strict))
+        {
+            bound = temp;
+            temp = temp->left;
+        }
+        else
+            temp = temp->right;
+    }
+
+    return bound;
+}
+
+/**
+ * @brief Takes every subtree that fits in a task whole and splits larger ones at their root,
+ *        gluing neighbouring pieces into one task while they fit
+ * @tparam T Data type stored in the tree
+ * @param wanted Number of tasks to aim for; each holds at most ceil(nodeCount() / wanted) nodes
+ * @return Tasks covering every node exactly once, in key order
+ * @note Uses the subtree sizes when Traits::orderStatistics is set: O(wanted * depth) for a
+ *       balanced tree, and one walk down the spine for a degenerate (list-like) one
+ */
+template<class T, class Allocator, class Traits>
+vector<typename SplayTree<T, Allocator, Traits>::VisitTask> SplayTree<T, Allocator, Traits>::splitForVisit(size_t wanted) const
+{
+    const size_t n = static_cast<size_t>(nodecount);
+    const size_t limit = wanted == 0 ? n : max<size_t>(1, (n + wanted - 1) / wanted);
+    if constexpr (!Traits::orderStatistics)
+        return splitUnsizedForVisit(wanted, limit);
+
+    vector<VisitTask> tasks;
+    VisitTask open{ nullptr, nullptr, 0 };
+    auto add = [&](Node* first, Node* last, size_t count) {
+        if (open.count != 0 && open.count + count <= limit)
+        {
+            open.last = last;
+            open.count += count;
+            return;
+        }
+        if (open.count != 0)
+            tasks.push_back(open);
+        open = { first, last, count };
+    };
+
+    // In-order over the oversized nodes, which wait on the stack until their left side is cut
+    vector<Node*> oversized;
+    Node* node = root;
+    for (;;)
+    {
+        while (node && sizeOf(node) > limit)
+        {
+            oversized.push_back(node);
+            node = node->left;
+        }
+        if (node)
+            add(leftmost(node), rightmost(node), sizeOf(node));
+        if (oversized.empty())
+            break;
+        node = oversized.back();
+        oversized.pop_back();
+        add(node, node, 1);
+        node = node->right;
+    }
+    if (open.count != 0)
+        tasks.push_back(open);
+    return tasks;
+}
+
+/**
+ * @brief Expands subtree tasks into (left subtree, node, right subtree) round by round until there
+ *        are enough, counts the subtrees in parallel, then cuts any task over twice the limit by walking it
+ * @tparam T Data type stored in the tree
+ * @note A balanced tree needs no cut; a degenerate one costs a serial walk of its spine, as without
+ *       sizes nothing else finds the middle of a list
+ */
+template<class T, class Allocator, class Traits>
+vector<typename SplayTree<T, Allocator, Traits>::VisitTask> SplayTree<T, Allocator, Traits>::splitUnsizedForVisit(size_t wanted, size_t limit) const
+{
+    // Subtree tasks are held as (root, nullptr, 0) until they are measured
+    vector<VisitTask> tasks;
+    if (root)
+        tasks.push_back({ root, nullptr, 0 });
+
+    for (size_t round = 0; round < 64 && tasks.size() < wanted; round++)
+    {
+        vector<VisitTask> next;
+        next.reserve(tasks.size() * 3);
+        bool expanded = false;
+        for (const VisitTask& task : tasks)
+        {
+            Node* node = task.first;
+            if (task.count != 0 || (!node->left && !node->right))
+            {
+                next.push_back({ node, node, 1 });
+                continue;
+            }
+            if (node->left) next.push_back({ node->left, nullptr, 0 });
+            next.push_back({ node, node, 1 });
+            if (node->right) next.push_back({ node->right, nullptr, 0 });
+            expanded = true;
+        }
+        tasks.swap(next);
+        if (!expanded)
+            break;
+    }
+
+    splay_detail::parallelFor(tasks.size(), [&tasks](size_t i) {
+        VisitTask& task = tasks[i];
+        if (task.count != 0)
+            return;
+        task.last = rightmost(task.first);
+        Node* node = leftmost(task.first);
+        task.first = node;
+        for (task.count = 1; node != task.last; task.count++)
+            node = nextNode(node);
+    });
+
+    vector<VisitTask> cut;
+    cut.reserve(tasks.size());
+    for (const VisitTask& task : tasks)
+    {
+        if (task.count <= 2 * limit)
+        {
+            cut.push_back(task);
+            continue;
+        }
+        Node* first = task.first;
+        for (size_t left = task.count; left > 0; )
+        {
+            const size_t count = min(left, limit);
+            Node* last = first;
+            for (size_t i = 1; i < count; i++)
+                last = nextNode(last);
+            cut.push_back({ first, last, count });
+            left -= count;
+            first = left > 0 ? nextNode(last) : nullptr;
+        }
+    }
+    return cut;
+}
+
+/**
+ * @brief Walks a task by successor steps from its first node to its last
+ * @tparam T Data type stored in the tree
+ */
+template<class T, class Allocator, class Traits>
+template<class Fn>
+void SplayTree<T, Allocator, Traits>::visitTask(const VisitTask& task, Fn& fn)
+{
+    for (Node* node = task.first; ; node = nextNode(node))
+    {
+        fn(static_cast<const T&>(node->data));
+        if (node == task.last)
+            break;
+    }
+}
+
+template<class T, class Allocator, class Traits>
+template<class Visit>
+void SplayTree<T, Allocator, Traits>::parallelForEach(Visit visit) const
+{
+    const size_t threads = splay_detail::parallelThreads();
+    if (static_cast<size_t>(nodecount) < Traits::parallelVisitThreshold || threads < 2)
+    {
+        for (const T& value : *this)
+            visit(value);
+        return;
+    }
+
+    vector<VisitTask> tasks = splitForVisit(threads * 8);
+    splay_detail::parallelFor(tasks.size(), [&](size_t i) { visitTask(tasks[i], visit); });
+}
+
+/**
+ * @brief Reduces every task on its own, then combines the partial results in task (= key) order
+ * @tparam T Data type stored in the tree
+ */
+template<class T, class Allocator, class Traits>
+template<class R, class Map, class Combine>
+R SplayTree<T, Allocator, Traits>::parallelReduce(R identity, Map map, Combine combine) const
+{
+    const size_t threads = splay_detail::parallelThreads();
+    if (static_cast<size_t>(nodecount) < Traits::parallelVisitThreshold || threads < 2)
+    {
+        R result = identity;
+        for (const T& value : *this)
+            result = combine(std::move(result), map(value));
+        return result;
+    }
+
+    // One slot per task (wrapped, so even vector<bool> would not share words between threads)
+    struct Partial { R value; };
+    vector<VisitTask> tasks = splitForVisit(threads * 8);
+    vector<Partial> partial(tasks.size(), Partial{ identity });
+    splay_detail::parallelFor(tasks.size(), [&](size_t i) {
+        R local = identity;
+        auto fold = [&](const T& value) { local = combine(std::move(local), map(value)); };
+        visitTask(tasks[i], fold);
+        partial[i].value = std::move(local);
+    });
+
+    R result = identity;
+    for (Partial& part : partial)
+        result = combine(std::move(result), std::move(part.value));
+    return result;
+}
+
+template<class T, class Allocator, class Traits>
+size_t SplayTree<T, Allocator, Traits>::sizeOf(const Node* node)
+{
+    if constexpr (Traits::orderStatistics)
+        return node ? node->size : 0;
+    else
+        return 0;
+}
+
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::updateAugments(Node* node)
+{
+    if constexpr (Traits::orderStatistics)
+        node->size = 1 + sizeOf(node->left) + sizeOf(node->right);
+
+    if constexpr (hasAggregate)
+    {
+        aggregate_type sum = Traits::measure(node->data);
+        if (node->left)
+            sum = Traits::combine(node->left->aggregate, sum);
+        if (node->right)
+            sum = Traits::combine(sum, node->right->aggregate);
+        node->aggregate = std::move(sum);
+    }
+}
+
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::refreshAugments(Node* node)
+{
+    if constexpr (augmented)
+    {
+        for (; node; node = node->parent)
+            updateAugments(node);
+    }
+}
+
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::aggregate_type SplayTree<T, Allocator, Traits>::aggregate() const
+{
+    static_assert(hasAggregate, "aggregate needs Traits::aggregate_type (see SplayTraits)");
+    return root ? root->aggregate : aggregate_type{};
+}
+
+/**
+ * @brief Range aggregate along the two boundary paths below the node where they part
+ * @tparam T Data type stored in the tree
+ * @param lo Smallest key included
+ * @param hi Largest key included
+ * @return combine() of the values with keys in [lo, hi] in key order, the identity if there are none
  *
+ * @details
+ * 1. Descends to the highest node inside the range, where the paths to lo and hi part
+ * 2. Walks toward lo in its left subtree; every node >= lo adds itself and its right subtree in front
+ * 3. Walks toward hi in its right subtree; every node <= hi adds its left subtree and itself behind
  */
-template<class T>
-typename SplayTree<T>::Node* SplayTree<T>::search(T data)
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::aggregate_type SplayTree<T, Allocator, Traits>::aggregateRange(const key_type& lo, const key_type& hi) const
 {
-    Node* temp = root;
-    Node* pred = nullptr;
+    static_assert(hasAggregate, "aggregateRange needs Traits::aggregate_type (see SplayTraits)");
 
-    while (temp)
+    Node* split = root;
+    while (split)
+    {
+        if (compareKey(lo, split->data) > 0)
+            split = split->right;
+        else if (compareKey(hi, split->data) < 0)
+            split = split->left;
+        else
+            break;
+    }
+    if (!split)
+        return aggregate_type{};
+
+    aggregate_type front{};
+    for (Node* node = split->left; node; )
     {
-        if (data == temp->data)
+        if (compareKey(lo, node->data) <= 0)
         {
-            splay(temp);
-            return root;
+            aggregate_type part = Traits::measure(node->data);
+            if (node->right)
+                part = Traits::combine(part, node->right->aggregate);
+            front = Traits::combine(part, front);
+            node = node->left;
         }
-
-        pred = temp;
-        if (data < temp->data)
-            temp = temp->left;
         else
-            temp = temp->right;
+            node = node->right;
     }
 
-    if (pred)
-        splay(pred);
+    aggregate_type back{};
+    for (Node* node = split->right; node; )
+    {
+        if (compareKey(hi, node->data) >= 0)
+        {
+            aggregate_type part = Traits::measure(node->data);
+            if (node->left)
+                part = Traits::combine(node->left->aggregate, part);
+            back = Traits::combine(back, part);
+            node = node->right;
+        }
+        else
+            node = node->left;
+    }
 
-    return nullptr; // not found
+    return Traits::combine(Traits::combine(front, Traits::measure(split->data)), back);
 }
 
 /**
- * @brief Searches for a node containing the specified ID and splays it to root
- * @param ID of data searched for
- * @return true if found, false otherwise
- * @author Tarek Mohamed
- *
- * @details This implementation:
- * 1. Performs standard BST search
- * 2. Splays the found node (or last accessed node) to root
- * 3. Maintains the splay tree's self-adjusting property
- *
- * @note The tree structure is modified during search to bring the found node to root
- * @warning Empty trees will return false without modification
- * @warning this will only exists when the templatized data has a function getCustomerID
- *
+ * @brief Descends toward key adding up the left subtrees (plus the node) of every step to the right
+ * @tparam T Data type stored in the tree
+ * @param key The key to rank
+ * @param strict False counts keys < key, true counts keys <= key
  */
-template<class T>
-typename SplayTree<T>::Node* SplayTree<T>::search(int id)
+template<class T, class Allocator, class Traits>
+size_t SplayTree<T, Allocator, Traits>::rankOf(const key_type& key, bool strict) const
 {
-    Node* curr = root;
+    static_assert(Traits::orderStatistics, "rank, select and countInRange need Traits::orderStatistics (see OrderStatisticsTraits)");
 
-    while (curr)
+    size_t rank = 0;
+    Node* temp = root;
+    while (temp)
     {
-        int currID = curr->data.getCustomerID();
-        if (id == currID)
-        {
-            splay(curr);
-            return curr;
-        }
-        else if (id < currID)
-        {
-            curr = curr->left;
-        }
+        int cmp = compareKey(key, temp->data);
+        if (cmp < 0 || (cmp == 0 && !strict))
+            temp = temp->left;
         else
         {
-            curr = curr->right;
+            rank += sizeOf(temp->left) + 1;
+            temp = temp->right;
         }
     }
-
-    return nullptr; // not found
+    return rank;
 }
 
-
-
-/*
- * @brief Splaying brings node to the root and make it the new root and preserves the BST structure (Tarek Mohamed)
- * @tparam T data type stored in the tree. Can be in our case a "BankAccount" class.
- * @param Node* node - The node which becomes the new root
- * @author Tarek Mohamed
+/**
+ * @brief Descends by subtree sizes to the node with k smaller keys
+ * @tparam T Data type stored in the tree
+ * @param k Index in key order, 0 is the smallest
+ * @return The node, nullptr if k >= nodeCount()
  */
-template<class T>
-void SplayTree<T>::splay(Node* node)
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::Node* SplayTree<T, Allocator, Traits>::selectNode(size_t k) const
 {
-    while (node != root)
+    static_assert(Traits::orderStatistics, "rank, select and countInRange need Traits::orderStatistics (see OrderStatisticsTraits)");
+
+    Node* temp = root;
+    while (temp)
     {
-        Node* parent = node->parent;
-        if (parent == root)
-        {
-            if (node == parent->left)
-                zig(parent);
-            else
-                zag(parent);
-        }
+        size_t leftSize = sizeOf(temp->left);
+        if (k == leftSize)
+            return temp;
+        if (k < leftSize)
+            temp = temp->left;
         else
         {
-            Node* grandParent = parent->parent;
-            if (node == parent->left)
-            {
-                if (parent == grandParent->left)
-                {
-                    zig(grandParent);
-                    zig(parent);
-                }
-                else
-                {
-                    zig(parent);
-                    zag(grandParent);
-                }
-            }
-            else
-            {
-                if (parent == grandParent->left)
-                {
-                    zag(parent);
-                    zig(grandParent);
-                }
-                else
-                {
-                    zag(grandParent);
-                    zag(parent);
-                }
-            }
+            k -= leftSize + 1;
+            temp = temp->right;
         }
     }
+    return nullptr;
 }
 
-/*
- * @brief Performs node right rotation
- * @tparam T data type stored in the tree. Can be in our case a "BankAccount" class.
- * @param Node* node - The node which becomes the rotation is performed on.
- * @author Tarek Mohamed
- */
-template<class T>
-void SplayTree<T>::zig(Node* node)
+template<class T, class Allocator, class Traits>
+size_t SplayTree<T, Allocator, Traits>::rank(const key_type& key) const
 {
-    Node* temp = node->left;
-    node->left = temp->right;
-    if (temp->right)
-        temp->right->parent = node;
+    return rankOf(key, false);
+}
 
-    temp->parent = node->parent;
-    if (!node->parent)
-        root = temp;
-    else if (node == node->parent->left)
-        node->parent->left = temp;
-    else // case node is the right child of its parent
-        node->parent->right = temp;
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::iterator SplayTree<T, Allocator, Traits>::select(size_t k, bool splayResult)
+{
+    Node* node = selectNode(k);
+    if (node && splayResult)
+        splay(node);
+    return iterator(node, this);
+}
 
-    temp->right = node;
-    node->parent = temp;
+template<class T, class Allocator, class Traits>
+size_t SplayTree<T, Allocator, Traits>::countInRange(const key_type& lo, const key_type& hi) const
+{
+    if (Traits::compare(hi, lo) < 0)
+        return 0;
+    return rankOf(hi, true) - rankOf(lo, false);
+}
+
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::iterator SplayTree<T, Allocator, Traits>::lower_bound(const key_type& key, bool splayResult)
+{
+    Node* node = lowerBoundNode(key, false);
+    if (node && splayResult)
+        splay(node);
+    return iterator(node, this);
+}
 
-    if (onRotationCallback) onRotationCallback(root);
+template<class T, class Allocator, class Traits>
+typename SplayTree<T, Allocator, Traits>::iterator SplayTree<T, Allocator, Traits>::upper_bound(const key_type& key, bool splayResult)
+{
+    Node* node = lowerBoundNode(key, true);
+    if (node && splayResult)
+        splay(node);
+    return iterator(node, this);
 }
 
-/*
- * @brief Performs node left rotation
- * @tparam T data type stored in the tree. Can be in our case a "BankAccount" class.
- * @param Node* node - The node which becomes the rotation is performed on.
- * @author Tarek Mohamed
+/**
+ * @brief Cuts the range [lo, hi] out of the tree and frees it
+ * @tparam T Data type stored in the tree
+ * @param lo Smallest key to remove
+ * @param hi Largest key to remove
+ * @return Number of elements removed
+ *
+ * @details
+ * 1. Splays the first node >= lo to the root and detaches its left subtree (keys < lo)
+ * 2. Splays the first node > hi to the root; its left subtree is now exactly the range
+ * 3. Frees the range and joins the two remaining parts with one more splay
  */
-template<class T>
-void SplayTree<T>::zag(Node* node)
+template<class T, class Allocator, class Traits>
+size_t SplayTree<T, Allocator, Traits>::eraseRange(const key_type& lo, const key_type& hi)
 {
-    Node* temp = node->right;
-    node->right = temp->left;
-
-    if (temp->left)
-        temp->left->parent = node;
+    Node* first = lowerBoundNode(lo, false);
+    if (!first || compareKey(hi, first->data) < 0)
+        return 0;
+    Node* stop = lowerBoundNode(hi, true);
 
-    temp->parent = node->parent;
+    splay(first);
+    Node* lower = root->left;
+    root->left = nullptr;
+    if (lower)
+        lower->parent = nullptr;
+    updateAugments(root);
 
-    if (!node->parent)
-        root = temp;
-    else if (node == node->parent->left)
-        node->parent->left = temp;
+    Node* range;
+    if (stop)
+    {
+        splay(stop); // first is below stop, so the range is stop's whole left subtree
+        range = root->left;
+        root->left = nullptr;
+        range->parent = nullptr;
+        updateAugments(root);
+    }
     else
-        node->parent->right = temp;
+    {
+        range = root;
+        root = nullptr;
+    }
 
-    temp->left = node;
-    node->parent = temp;
+    joinNodes(lower, root);
+    size_t removed = destroySubtree(range);
+    nodecount -= static_cast<int>(removed);
+    return removed;
+}
 
-    if (onRotationCallback) onRotationCallback(root);
+/**
+ * @brief Splits at the first key >= key, which becomes the root of the returned tree
+ * @tparam T Data type stored in the tree
+ * @param key Smallest key of the returned tree
+ * @return Tree holding the elements with keys >= key
+ * @note The two halves are counted in step and the walk stops at the end of the shorter one
+ */
+template<class T, class Allocator, class Traits>
+SplayTree<T, Allocator, Traits> SplayTree<T, Allocator, Traits>::split(const key_type& key)
+{
+    SplayTree upper(get_allocator());
+    Node* bound = lowerBoundNode(key, false);
+    if (!bound)
+        return upper;
+
+    splay(bound);
+    upper.root = root;
+    root = root->left;
+    upper.root->left = nullptr;
+    if (root)
+        root->parent = nullptr;
+    updateAugments(upper.root);
+
+    if constexpr (Traits::orderStatistics)
+    {
+        upper.nodecount = static_cast<int>(sizeOf(upper.root));
+        nodecount -= upper.nodecount;
+        return upper;
+    }
 
+    int steps = 0;
+    Node* a = leftmost(root);
+    Node* b = leftmost(upper.root);
+    while (a && b)
+    {
+        a = nextNode(a);
+        b = nextNode(b);
+        steps++;
+    }
+    upper.nodecount = b ? nodecount - steps : steps;
+    nodecount -= upper.nodecount;
+    return upper;
 }
 
-template<class T>
-typename SplayTree<T>::Node* SplayTree<T>::findPred(T data) const
+/**
+ * @brief Joins another tree into this one, by linking when the key ranges do not overlap
+ * @tparam T Data type stored in the tree
+ * @param other Tree to take the elements from; empty afterwards
+ */
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::join(SplayTree& other)
 {
-    Node* temp = root;
-    Node* pred = nullptr;
+    if (this == &other || !other.root)
+        return;
 
-    while (temp)
+    const bool sameAlloc = nodeAlloc == other.nodeAlloc;
+    if (!root && (sameAlloc || NodeAllocTraits::propagate_on_container_swap::value))
     {
-        if (data == temp->data)
-            break;
+        swap(other);
+        return;
+    }
 
-        pred = temp;
-        if (data < temp->data)
-            temp = temp->left;
-        else
-            temp = temp->right;
+    if (sameAlloc && compareKey(Traits::keyOf(leftmost(other.root)->data), lastNode()->data) > 0)
+        joinNodes(root, other.root);
+    else if (sameAlloc && compareKey(Traits::keyOf(other.lastNode()->data), firstNode()->data) < 0)
+        joinNodes(other.root, root);
+    else
+    {
+        // Overlapping keys or foreign nodes: move the values over
+        vector<T> values;
+        values.reserve(static_cast<size_t>(other.nodecount));
+        for (T& value : other)
+            values.push_back(std::move(value));
+        other.clear();
+        mergeFrom(std::move(values));
+        return;
     }
 
-    return pred;
+    nodecount += other.nodecount;
+    other.root = nullptr;
+    other.nodecount = 0;
 }
 
-template<class T>
-typename SplayTree<T>::Node* SplayTree<T>::searchNoSplay(T data) const
+/**
+ * @brief Splays the largest node of lower to the root and hangs upper off its empty right side
+ * @tparam T Data type stored in the tree
+ */
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::joinNodes(Node* lower, Node* upper)
 {
-    Node* temp = root;
-    Node* pred = nullptr;
-
-    while (temp)
+    root = lower;
+    if (!lower)
     {
-        if (data == temp->data)
-            return temp;
+        root = upper;
+        return;
+    }
 
-        pred = temp;
-        if (data < temp->data)
-            temp = temp->left;
+    splay(lastNode());
+    root->right = upper;
+    if (upper)
+        upper->parent = root;
+    updateAugments(root);
+}
+
+/**
+ * @brief Frees a subtree by rotating left children up until each node has none, then dropping it
+ * @tparam T Data type stored in the tree
+ * @return Number of nodes freed
+ */
+template<class T, class Allocator, class Traits>
+size_t SplayTree<T, Allocator, Traits>::destroySubtree(Node* node)
+{
+    size_t destroyed = 0;
+    while (node)
+    {
+        if (node->left)
+        {
+            Node* left = node->left;
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        }
         else
-            temp = temp->right;
+        {
+            Node* right = node->right;
+            destroyNode(node);
+            node = right;
+            destroyed++;
+        }
     }
+    return destroyed;
+}
 
-    return nullptr; // not found
+/**
+ * @brief Keys are unique, so the range holds at most the one element equal to key
+ * @tparam T Data type stored in the tree
+ * @note The end of the range is found by stepping from its start, not by a second descent
+ */
+template<class T, class Allocator, class Traits>
+pair<typename SplayTree<T, Allocator, Traits>::iterator, typename SplayTree<T, Allocator, Traits>::iterator>
+SplayTree<T, Allocator, Traits>::equal_range(const key_type& key, bool splayResult)
+{
+    iterator first = lower_bound(key, splayResult);
+    iterator last = first;
+    if (first != end() && compareKey(key, *first) == 0)
+        ++last;
+    return { first, last };
+}
+
+template<class T, class Allocator, class Traits>
+pair<typename SplayTree<T, Allocator, Traits>::const_iterator, typename SplayTree<T, Allocator, Traits>::const_iterator>
+SplayTree<T, Allocator, Traits>::equal_range(const key_type& key) const
+{
+    const_iterator first = lower_bound(key);
+    const_iterator last = first;
+    if (first != end() && compareKey(key, *first) == 0)
+        ++last;
+    return { first, last };
 }
 
 /**
- * @brief Removes a node containing the specified data
- * @tparam T Data type stored in the tree (must support comparison operators)
- * @param data The value to remove from the tree
+ * @brief Removes the node with the specified key
+ * @tparam T Data type stored in the tree
+ * @param key The key of the value to remove from the tree
  * @return true if found and removed, false if not found
  * @author Tarek Mohamed
  *
@@ -623,6 +2617,9 @@ typename SplayTree<T>::Node* SplayTree<T>::searchNoSplay(T data) const
  * - inorder pred. if (root & both subtrees exist)
  * - none if(root & one subtree exit) i.e. only assign the root to the subtree's root
  *
+ * The node is located in a single descent. In SplayMode::TopDown the descent itself splays,
+ * and the left part is then splayed on its maximum so the right part can be attached to it.
+ *
  *
  * Example usage:
  * @code
@@ -631,15 +2628,49 @@ typename SplayTree<T>::Node* SplayTree<T>::searchNoSplay(T data) const
  * bool removed = tree.erase(5); // returns true
  * @endcode
  */
-template<class T>
-bool SplayTree<T>::erase(T data) {
+template<class T, class Allocator, class Traits>
+bool SplayTree<T, Allocator, Traits>::erase(const key_type& key) {
     if (!root) return false;
 
-    Node* deleteNode = searchNoSplay(data);
+    if constexpr (Traits::mode == SplayMode::TopDown) {
+        if (splayTopDown([&key](const T& other) { return compareKey(key, other); }) != 0)
+            return false; // Data not found - the last accessed node is already at the root
+
+        Node* leftTree = root->left;
+        Node* rightTree = root->right;
+        destroyNode(root);
+
+        if (!leftTree) {
+            root = rightTree;
+            if (root) root->parent = nullptr;
+        }
+        else {
+            leftTree->parent = nullptr;
+            root = leftTree;
+            splayTopDown([](const T&) { return 1; }); // Maximum of the left part, has no right child
+            root->right = rightTree;
+            if (rightTree) rightTree->parent = root;
+            updateAugments(root);
+        }
+        nodecount--;
+        return true;
+    }
+
+    Node* deleteNode = root;
+    Node* lastVisited = nullptr;
+    size_t compared = 0;
+    while (deleteNode) {
+        int cmp = compareKey(key, deleteNode->data);
+        compared++;
+        if (cmp == 0) break;
+        lastVisited = deleteNode;
+        deleteNode = (cmp < 0) ? deleteNode->left : deleteNode->right;
+    }
+    countDescent(compared);
+
     if (deleteNode == nullptr) {
         // Data not found - splay the last accessed node
-        Node* splayTarget = findPred(data);
-        if (splayTarget) splay(splayTarget);
+        splay(lastVisited);
         return false;
     }
 
@@ -653,7 +2684,7 @@ bool SplayTree<T>::erase(T data) {
     if (leftTree) leftTree->parent = nullptr;
     if (rightTree) rightTree->parent = nullptr;
 
-    delete root;
+    destroyNode(root);
 
     if (!leftTree) {
         root = rightTree;
@@ -678,6 +2709,7 @@ bool SplayTree<T>::erase(T data) {
         // Attach right tree
         maxLeft->right = rightTree;
         rightTree->parent = maxLeft;
+        updateAugments(maxLeft);
         root = maxLeft;
     }
     nodecount--;
@@ -690,8 +2722,8 @@ bool SplayTree<T>::erase(T data) {
  * @return Integer representing the number of nodes.
  * @author Nour Mamdouh
  */
-template<class T>
-int SplayTree<T>::nodeCount() const {
+template<class T, class Allocator, class Traits>
+int SplayTree<T, Allocator, Traits>::nodeCount() const {
     return nodecount;
 }
 
@@ -699,18 +2731,127 @@ int SplayTree<T>::nodeCount() const {
  * @brief Calculates the height of the subtree rooted at the given node.
  * @tparam T Data type stored in the tree.
  * @param ptr Pointer to the root of the subtree.
- * @return Height of the subtree. Returns 0 if ptr is null.
+ * @return Number of levels of the subtree. Returns 0 if ptr is null, 1 for a leaf.
+ * @details Iterative walk over the parent links (see walkDepths), O(n) time and O(1) extra space.
  * @author Nour Mamdouh
  */
-template<class T>
-int SplayTree<T>::height(SplayTree<T>::Node* ptr) const {
-    int max_left, max_right = 0;
+template<class T, class Allocator, class Traits>
+int SplayTree<T, Allocator, Traits>::height(SplayTree<T, Allocator, Traits>::Node* ptr) const {
+    size_t deepest = 0;
     if (!ptr) {
         return 0;
     }
-    max_left = height(ptr->left);
-    max_right = height(ptr->right);
-    return (max_left >= max_right) ? max_left : max_right;
+    walkDepths(ptr, [&deepest](Node*, size_t depth) { if (depth > deepest) deepest = depth; });
+    return static_cast<int>(deepest + 1);
+}
+
+/**
+ * @brief Visits a subtree in key order without recursion or an explicit stack
+ * @tparam T Data type stored in the tree
+ * @param node Root of the subtree; its parent link is not followed
+ * @param visit Called as visit(Node*, size_t depth), the subtree root being at depth 0
+ * @details Descends to the leftmost node, then steps to the in-order successor: down to the
+ * leftmost node of the right subtree, or up until coming from a left child. The depth goes
+ * up and down with every link followed.
+ */
+template<class T, class Allocator, class Traits>
+template<class Visit>
+void SplayTree<T, Allocator, Traits>::walkDepths(Node* node, Visit visit)
+{
+    if (!node)
+        return;
+
+    size_t depth = 0;
+    while (node->left) { node = node->left; depth++; }
+
+    for (;;)
+    {
+        visit(node, depth);
+
+        if (node->right)
+        {
+            node = node->right;
+            depth++;
+            while (node->left) { node = node->left; depth++; }
+            continue;
+        }
+
+        // Climb while coming from a right child; the subtree is done once its root is left behind
+        while (depth > 0 && node == node->parent->right) { node = node->parent; depth--; }
+        if (depth == 0)
+            return;
+        node = node->parent;
+        depth--;
+    }
+}
+
+/**
+ * @brief Depth histogram of every stride-th node in key order
+ * @tparam T Data type stored in the tree
+ * @param stride Sampling step, 1 profiles every node
+ * @return Element d counts the sampled nodes at depth d; empty for an empty tree
+ */
+template<class T, class Allocator, class Traits>
+vector<size_t> SplayTree<T, Allocator, Traits>::depthProfile(size_t stride) const
+{
+    vector<size_t> profile;
+    if (stride == 0) stride = 1;
+    size_t index = 0;
+    walkDepths(root, [&](Node*, size_t depth) {
+        if (index++ % stride != 0)
+            return;
+        if (depth >= profile.size())
+            profile.resize(depth + 1);
+        profile[depth]++;
+    });
+    return profile;
+}
+
+/**
+ * @brief Snapshot of the operation counters
+ * @tparam T Data type stored in the tree
+ * @return The counters (all zero unless Traits::collectStats), with liveNodes and nodeBytes filled in
+ */
+template<class T, class Allocator, class Traits>
+SplayStats SplayTree<T, Allocator, Traits>::stats() const
+{
+    SplayStats result;
+    if constexpr (Traits::collectStats)
+        result = counters;
+    result.liveNodes = static_cast<size_t>(nodecount);
+    result.nodeBytes = result.liveNodes * sizeof(Node);
+    return result;
+}
+
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::resetStats()
+{
+    if constexpr (Traits::collectStats)
+        counters = SplayStats();
+}
+
+/**
+ * @brief Counts the comparisons of a bottom-up descent and the depth where it stopped
+ * @tparam T Data type stored in the tree
+ * @param compared Nodes compared with the key, 0 for an empty tree
+ */
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::countDescent(size_t compared) const
+{
+    if constexpr (Traits::collectStats)
+    {
+        if (compared == 0)
+            return;
+        counters.comparisons += compared;
+        counters.recordDepth(compared - 1);
+    }
+}
+
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::countLookup(bool hit) const
+{
+    if constexpr (Traits::collectStats)
+        (hit ? counters.hits : counters.misses)++;
 }
 
 /**
@@ -719,8 +2860,8 @@ int SplayTree<T>::height(SplayTree<T>::Node* ptr) const {
  * @return True if the tree has no nodes, otherwise false.
  * @author Nour Mamdouh
  */
-template<class T>
-bool SplayTree<T>::empty() const {
+template<class T, class Allocator, class Traits>
+bool SplayTree<T, Allocator, Traits>::empty() const {
     return nodeCount() == 0;
 }
 
@@ -731,12 +2872,9 @@ bool SplayTree<T>::empty() const {
  * @param out Output stream to print the traversal.
  * @author Nour Mamdouh
  */
-template<class T>
-void SplayTree<T>::inorder(SplayTree<T>::Node* ptr, ostream& out) const {
-    if (!ptr) return;
-    inorder(ptr->left, out);
-    out << ptr->data << " ";
-    inorder(ptr->right, out);
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::inorder(SplayTree<T, Allocator, Traits>::Node* ptr, ostream& out) const {
+    walkDepths(ptr, [&out](Node* node, size_t) { out << node->data << " "; });
 }
 
 /**
@@ -745,25 +2883,13 @@ void SplayTree<T>::inorder(SplayTree<T>::Node* ptr, ostream& out) const {
  * @tparam T Data type stored in the tree.
  * @author Tarek Mohamed
  */
-template<class T>
-vector<T> SplayTree<T>::collectInOrder(vector<T>& result) const {
-    collectInOrderHelper(root, result);
+template<class T, class Allocator, class Traits>
+vector<T>& SplayTree<T, Allocator, Traits>::collectInOrder(vector<T>& result) const {
+    result.reserve(result.size() + static_cast<size_t>(nodecount));
+    result.insert(result.end(), begin(), end());
     return result;
 }
 
-template<class T>
-inline void SplayTree<T>::setOnRotationCallback(std::function<void(NodeType* root)> callback)
-{
-    onRotationCallback = std::move(callback);
-}
-
-template<class T>
-void SplayTree<T>::collectInOrderHelper(Node* node, std::vector<T>& result) const {
-    if (!node) return;
-    collectInOrderHelper(node->left, result);
-    result.push_back(node->data);
-    collectInOrderHelper(node->right, result);
-}
 
 
 
@@ -774,12 +2900,24 @@ void SplayTree<T>::collectInOrderHelper(Node* node, std::vector<T>& result) cons
  * @param out Output stream to print the traversal.
  * @author Nour Mamdouh
  */
-template<class T>
-void SplayTree<T>::preorder(SplayTree::Node* ptr, ostream& out) const {
-    if (!ptr) return;
-    out << ptr->data << " ";
-    preorder(ptr->left, out);
-    preorder(ptr->right, out);
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::preorder(SplayTree::Node* ptr, ostream& out) const {
+    Node* node = ptr;
+    while (node) {
+        out << node->data << " ";
+        if (node->left) {
+            node = node->left;
+        }
+        else if (node->right) {
+            node = node->right;
+        }
+        else {
+            // Climb to the nearest ancestor whose right subtree is still to come
+            while (node != ptr && (node == node->parent->right || !node->parent->right))
+                node = node->parent;
+            node = (node == ptr) ? nullptr : node->parent->right;
+        }
+    }
 }
 
 /**
@@ -790,8 +2928,8 @@ void SplayTree<T>::preorder(SplayTree::Node* ptr, ostream& out) const {
  * @note If the tree is empty, a message is printed to standard error.
  * @author Nour Mamdouh
  */
-template<class T>
-void SplayTree<T>::display(ostream& out, int printMode) const {
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::display(ostream& out, int printMode) const {
     if (empty()) {
         cerr << "Cannot traverse an empty tree!" << endl;
         return;
@@ -817,8 +2955,8 @@ void SplayTree<T>::display(ostream& out, int printMode) const {
  * @author Nour Mamdouh
  *
  */
-template<class T>
-ostream& operator<<(ostream& out, const SplayTree<T>& tree) {
+template<class T, class Allocator, class Traits>
+ostream& operator<<(ostream& out, const SplayTree<T, Allocator, Traits>& tree) {
     tree.display(out);
     return out;
 }
@@ -831,11 +2969,11 @@ ostream& operator<<(ostream& out, const SplayTree<T>& tree) {
  * @return Reference to the input stream.
  * @author Nour Mamdouh
  */
-template<class T>
-istream& operator>>(istream& in, SplayTree<T>& tree) {
+template<class T, class Allocator, class Traits>
+istream& operator>>(istream& in, SplayTree<T, Allocator, Traits>& tree) {
     T data;
     in >> data;
-    tree.insert(data);
+    tree.insert(std::move(data));
     return in;
 }
 
@@ -847,21 +2985,19 @@ istream& operator>>(istream& in, SplayTree<T>& tree) {
  * @note If the tree is empty, an error message is printed.
  * @author Nour Mamdouh
  */
-template<class T>
-void SplayTree<T>::leafNodesHelper(ostream& out, Node* ptr) const {
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::leafNodesHelper(ostream& out, Node* ptr) const {
     if (empty()) {
         cerr << "Empty Tree!!";
         return;
     }
-    if (!ptr) return;
-    if (!ptr->left && !ptr->right) {
-        out << ptr->data << endl;
-    }
-    leafNodesHelper(out, ptr->left);
-    leafNodesHelper(out, ptr->right);
+    walkDepths(ptr, [&out](Node* node, size_t) {
+        if (!node->left && !node->right)
+            out << node->data << endl;
+        });
 }
 
-template<class T>
-void SplayTree<T>::leafNodes(std::ostream& out) const {
+template<class T, class Allocator, class Traits>
+void SplayTree<T, Allocator, Traits>::leafNodes(std::ostream& out) const {
     leafNodesHelper(out, root);
 }
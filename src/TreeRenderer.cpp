@@ -0,0 +1,144 @@
+#include "TreeRenderer.h"
+#include <QBrush>
+
+void TreeRenderer::refresh(const Shape& shape)
+{
+	frame++;
+	if (const Key* root = shape.root())
+		layout(shape, root, 0, shape.sizeOf(shape.at(*root).left), nullptr);
+	releaseStale(shown.begin(), shown.end());
+}
+
+void TreeRenderer::refreshSubtree(const Shape& shape, const Key& top)
+{
+	frame++;
+
+	// The subtree holds one contiguous key range, bounded by its leftmost and rightmost nodes
+	const Key* lo = &top;
+	const Key* hi = &top;
+	while (const Key* left = shape.at(*lo).left) lo = left;
+	while (const Key* right = shape.at(*hi).right) hi = right;
+	ItemMap::iterator first = shown.lower_bound(*lo);
+	ItemMap::iterator last = shown.upper_bound(*hi);
+
+	// Nothing of the subtree is visible when it or an ancestor is beyond the limit or folded
+	size_t depth = shape.depthOf(top);
+	bool visible = depth <= depthLimit;
+	const Key* parent = shape.at(top).parent;
+	size_t upDepth = depth;
+	for (const Key* up = parent; visible && up; up = shape.at(*up).parent)
+		visible = !folded(shape, shape.at(*up), --upDepth);
+
+	if (visible)
+	{
+		QPointF parentAt;
+		if (parent)
+			parentAt = place(shape.rankOf(*parent), depth - 1);
+		layout(shape, &top, depth, shape.rankOf(top), parent ? &parentAt : nullptr);
+	}
+	releaseStale(first, last);
+}
+
+void TreeRenderer::clear()
+{
+	for (ItemMap::iterator it = shown.begin(); it != shown.end(); )
+		it = release(it);
+}
+
+QPointF TreeRenderer::position(const Key& key) const
+{
+	ItemMap::const_iterator found = shown.find(key);
+	return found == shown.end() ? QPointF() : found->second.label->pos();
+}
+
+QRectF TreeRenderer::bounds(const Shape& shape) const
+{
+	return QRectF(-columnWidth, -rowHeight, (shape.size() + 2) * columnWidth, (depthLimit + 3) * rowHeight);
+}
+
+void TreeRenderer::layout(const Shape& shape, const Key* key, size_t depth, size_t rank, const QPointF* parentAt)
+{
+	const Shape::Links& links = shape.at(*key);
+	NodeItem& item = show(*key);
+	item.frame = frame;
+
+	// Qt ignores setPos and setLine calls that change nothing, so unmoved nodes cost no repaint
+	QPointF at = place(rank, depth);
+	item.label->setPos(at);
+	if (parentAt)
+	{
+		item.edge->setLine(QLineF(*parentAt + QPointF(10, 20), at + QPointF(10, 0)));
+		item.edge->show();
+	}
+	else
+		item.edge->hide();
+
+	if (!links.left && !links.right)
+	{
+		item.fold->hide();
+		return;
+	}
+	if (folded(shape, links, depth))
+	{
+		item.fold->setText(QString("+%1").arg(links.size - 1));
+		item.fold->setPos(at + QPointF(0, 20));
+		item.fold->show();
+		return;
+	}
+	item.fold->hide();
+
+	// Recursion is bounded by the depth limit
+	if (links.left)
+		layout(shape, links.left, depth + 1, rank - shape.sizeOf(shape.at(*links.left).right) - 1, &at);
+	if (links.right)
+		layout(shape, links.right, depth + 1, rank + shape.sizeOf(shape.at(*links.right).left) + 1, &at);
+}
+
+bool TreeRenderer::folded(const Shape& shape, const Shape::Links& links, size_t depth) const
+{
+	if (depth >= depthLimit)
+		return true;
+	bool cold = shape.now() - links.touched > coldAfter;
+	return cold && depth >= coldDepth && links.size >= coldMinSize;
+}
+
+void TreeRenderer::releaseStale(ItemMap::iterator first, ItemMap::iterator last)
+{
+	while (first != last)
+		first = first->second.frame == frame ? next(first) : release(first);
+}
+
+TreeRenderer::NodeItem& TreeRenderer::show(const Key& key)
+{
+	ItemMap::iterator found = shown.find(key);
+	if (found != shown.end())
+		return found->second;
+
+	NodeItem item;
+	if (!pool.empty())
+	{
+		item = pool.back();
+		pool.pop_back();
+	}
+	else
+	{
+		item.label = scene->addSimpleText(QString());
+		item.edge = scene->addLine(QLineF());
+		item.edge->setZValue(-1);
+		item.fold = scene->addSimpleText(QString());
+		item.fold->setBrush(QBrush(Qt::gray));
+	}
+	item.label->setText(QString::number(key));
+	item.label->show();
+	return shown.emplace(key, item).first->second;
+}
+
+TreeRenderer::ItemMap::iterator TreeRenderer::release(ItemMap::iterator it)
+{
+	NodeItem& item = it->second;
+	item.label->hide();
+	item.edge->hide();
+	item.fold->hide();
+	pool.push_back(item);
+	return shown.erase(it);
+}
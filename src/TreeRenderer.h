@@ -0,0 +1,105 @@
+#pragma once
+#include <QGraphicsScene>
+#include <QGraphicsSimpleTextItem>
+#include <QGraphicsLineItem>
+#include <map>
+#include <vector>
+#include "RotationTrace.h"
+
+using namespace std;
+
+/**
+ * @brief Draws a TreeShape into a scene and reuses its items from frame to frame.
+ *
+ * The layout is tidy and needs no global pass: a node's column is its in-order rank and its row
+ * is its depth, so no two nodes overlap. A rotation keeps every rank and changes depths only
+ * inside the subtree that the pivot now roots. After a step only that subtree is laid out again
+ * (refreshSubtree), and the items of the rest of the tree stay untouched. An item that leaves
+ * the view goes back to a pool instead of being deleted.
+ *
+ * Level of detail: a node is drawn folded, with the number of nodes below it, when it sits at the
+ * depth limit. A large subtree is also folded when it sits at coldDepth or below and its root was
+ * not rotated within the last coldAfter steps. Big trees then only get items for their top levels
+ * and the paths splayed recently.
+ */
+class TreeRenderer
+{
+public:
+	using Key = int;
+	using Shape = TreeShape<Key>;
+
+	/*
+	*  @param scene Owns the items; it must outlive the renderer and must not be cleared behind its back
+	*/
+	explicit TreeRenderer(QGraphicsScene* scene) : scene(scene) {}
+
+	void setDepthLimit(size_t depth) { depthLimit = depth; }
+
+	/*
+	*  @brief Folds subtrees of at least minSize nodes at depth or below once steps have passed without a rotation in them
+	*/
+	void setColdFolding(size_t depth, size_t steps, size_t minSize) { coldDepth = depth; coldAfter = steps; coldMinSize = minSize; }
+
+	/*
+	*  @brief Lays out the visible part of the whole shape: moves, adds and pools items as needed
+	*/
+	void refresh(const Shape& shape);
+
+	/*
+	*  @brief Lays out only the subtree rooted at top, e.g. the pivot of the step just applied
+	*/
+	void refreshSubtree(const Shape& shape, const Key& top);
+
+	/*
+	*  @brief Returns every item to the pool
+	*/
+	void clear();
+
+	size_t visibleNodes() const { return shown.size(); }
+
+	/*
+	*  @brief Scene position of a node's label, (0, 0) if the node is not shown
+	*/
+	QPointF position(const Key& key) const;
+
+	/*
+	*  @brief Area the shape can occupy, for the scene rectangle
+	*/
+	QRectF bounds(const Shape& shape) const;
+
+private:
+	struct NodeItem
+	{
+		QGraphicsSimpleTextItem* label = nullptr;
+		QGraphicsLineItem* edge = nullptr;       ///< Up to the parent, hidden for the root.
+		QGraphicsSimpleTextItem* fold = nullptr; ///< "+n" under a folded node.
+		size_t frame = 0;                        ///< Last layout pass that showed the node.
+	};
+
+	using ItemMap = map<Key, NodeItem>;
+
+	static constexpr qreal columnWidth = 40;
+	static constexpr qreal rowHeight = 60;
+
+	static QPointF place(size_t rank, size_t depth) { return QPointF(rank * columnWidth, depth * rowHeight); }
+
+	void layout(const Shape& shape, const Key* key, size_t depth, size_t rank, const QPointF* parentAt);
+	bool folded(const Shape& shape, const Shape::Links& links, size_t depth) const;
+
+	/*
+	*  @brief Pools the items in [first, last) that the current pass did not show
+	*/
+	void releaseStale(ItemMap::iterator first, ItemMap::iterator last);
+
+	NodeItem& show(const Key& key);
+	ItemMap::iterator release(ItemMap::iterator it);
+
+	QGraphicsScene* scene;
+	ItemMap shown;           ///< Ordered by key, so the items of a subtree form one range.
+	vector<NodeItem> pool;
+	size_t frame = 0;
+	size_t depthLimit = 12;
+	size_t coldDepth = 5;
+	size_t coldAfter = 256;
+	size_t coldMinSize = 64;
+};
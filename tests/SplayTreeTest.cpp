@@ -0,0 +1,679 @@
+/**
+ * @file SplayTreeTest.cpp
+ * @brief Differential test of SplayTree against std::map (no Qt needed).
+ *
+ * Random operation streams run on a SplayTree and a std::map side by side, in both splay modes
+ * and with subtree sizes and aggregates switched on. After every step the answers must agree
+ * and the tree's links, key order, subtree sizes and aggregates are checked node by node.
+ * CompactSplayTree runs the same kind of streams next to a SplayTree of the same mode, and must
+ * hold the same values in a tree of the same shape.
+ * A failed check prints its location and the test exits with a non-zero status.
+ */
+#include "SplayTree.h"
+#include "CompactSplayTree.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <new>
+#include <random>
+
+#define CHECK(condition)                                                                         \
+    do {                                                                                         \
+        if (!(condition)) {                                                                      \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                          \
+        }                                                                                        \
+    } while (0)
+
+namespace
+{
+    int failures = 0;
+
+    struct KV
+    {
+        int key;
+        long long value;
+    };
+
+    /**
+     * @brief Keyed by key, with subtree sizes and the sum of the values as aggregate.
+     */
+    template <SplayMode Mode>
+    struct SumTraits : SplayTraits<KV>
+    {
+        static constexpr SplayMode mode = Mode;
+        static constexpr bool orderStatistics = true;
+        using key_type = int;
+        using aggregate_type = long long;
+
+        static int keyOf(const KV& kv) { return kv.key; }
+        static long long measure(const KV& kv) { return kv.value; }
+        static long long combine(long long a, long long b) { return a + b; }
+    };
+
+    /**
+     * @brief Keyed by key, without subtree sizes or aggregates.
+     */
+    template <SplayMode Mode = SplayMode::BottomUp>
+    struct PlainTraits : SplayTraits<KV>
+    {
+        static constexpr SplayMode mode = Mode;
+        using key_type = int;
+        static int keyOf(const KV& kv) { return kv.key; }
+    };
+
+    using Reference = std::map<int, long long>;
+
+    long allocationBudget = -1; ///< Allocations FailingAllocator grants before throwing, -1 for no limit.
+    long liveAllocations = 0;
+
+    /**
+     * @brief std::allocator that throws std::bad_alloc once allocationBudget runs out.
+     */
+    template <class U>
+    struct FailingAllocator
+    {
+        using value_type = U;
+
+        FailingAllocator() = default;
+        template <class V>
+        FailingAllocator(const FailingAllocator<V>&) {}
+
+        U* allocate(size_t n)
+        {
+            if (allocationBudget == 0)
+                throw std::bad_alloc();
+            if (allocationBudget > 0)
+                allocationBudget--;
+            liveAllocations++;
+            return std::allocator<U>().allocate(n);
+        }
+
+        void deallocate(U* p, size_t n)
+        {
+            liveAllocations--;
+            std::allocator<U>().deallocate(p, n);
+        }
+
+        template <class V>
+        bool operator==(const FailingAllocator<V>&) const { return true; }
+        template <class V>
+        bool operator!=(const FailingAllocator<V>&) const { return false; }
+    };
+
+    long long referenceSum(const Reference& ref, int lo, int hi)
+    {
+        long long sum = 0;
+        for (auto it = ref.lower_bound(lo); it != ref.end() && it->first <= hi; ++it)
+            sum += it->second;
+        return sum;
+    }
+
+    /**
+     * @brief Checks links, order, sizes and aggregates of every node, then the contents against ref.
+     */
+    template <class Tree>
+    void checkTree(const Tree& tree, const Reference& ref)
+    {
+        using Node = typename Tree::NodeType;
+        CHECK(tree.nodeCount() == static_cast<int>(ref.size()));
+        CHECK(tree.empty() == ref.empty());
+
+        const Node* root = tree.getRoot();
+        CHECK(!root || !root->parent);
+        size_t visited = 0;
+        // Post-order over the parent links, so children are verified before their parent
+        const Node* node = root;
+        const Node* from = nullptr;
+        while (node)
+        {
+            if (from == node->parent && node->left)
+            {
+                from = node;
+                node = node->left;
+                continue;
+            }
+            if ((from == node->parent || from == node->left) && node->right)
+            {
+                from = node;
+                node = node->right;
+                continue;
+            }
+
+            visited++;
+            size_t size = 1;
+            long long sum = node->data.value;
+            if (node->left)
+            {
+                CHECK(node->left->parent == node);
+                CHECK(node->left->data.key < node->data.key);
+                size += node->left->size;
+                sum += node->left->aggregate;
+            }
+            if (node->right)
+            {
+                CHECK(node->right->parent == node);
+                CHECK(node->right->data.key > node->data.key);
+                size += node->right->size;
+                sum += node->right->aggregate;
+            }
+            CHECK(node->size == size);
+            CHECK(node->aggregate == sum);
+
+            from = node;
+            node = node->parent;
+        }
+        CHECK(visited == ref.size());
+
+        auto it = ref.begin();
+        for (const KV& kv : tree)
+        {
+            if (it == ref.end()) { CHECK(false); break; }
+            CHECK(kv.key == it->first && kv.value == it->second);
+            ++it;
+        }
+        CHECK(it == ref.end());
+
+        long long total = 0;
+        for (const auto& entry : ref)
+            total += entry.second;
+        CHECK(tree.aggregate() == total);
+    }
+
+    /// The empty tree's first insert is linked without any rotation; its aggregate must still be measured.
+    template <SplayMode Mode>
+    void singleElementAggregates()
+    {
+        using Tree = SplayTree<KV, std::allocator<KV>, SumTraits<Mode>>;
+
+        Tree tree;
+        CHECK(tree.aggregate() == 0);
+        tree.insert(KV{ 5, 7 });
+        CHECK(tree.aggregate() == 7);
+        CHECK(tree.aggregateRange(5, 5) == 7);
+        CHECK(tree.rank(6) == 1);
+
+        Tree emplaced;
+        emplaced.emplace(KV{ 3, 11 });
+        CHECK(emplaced.aggregate() == 11);
+
+        Tree tried;
+        tried.try_emplace(4, KV{ 4, 13 });
+        CHECK(tried.aggregate() == 13);
+
+        Tree assigned;
+        assigned.insert_or_assign(KV{ 2, 17 });
+        CHECK(assigned.aggregate() == 17);
+
+        // Erase down to empty, then start again
+        tree.insert(KV{ 9, 1 });
+        CHECK(tree.erase(5));
+        CHECK(tree.erase(9));
+        CHECK(tree.aggregate() == 0);
+        tree.insert(KV{ 8, 19 });
+        CHECK(tree.aggregate() == 19);
+
+        Reference ref{ { 8, 19 } };
+        checkTree(tree, ref);
+    }
+
+    /**
+     * @brief Keys seen by parallelReduce: combining two runs is only valid if the left one ends below the right one.
+     */
+    struct KeyRun
+    {
+        long long count = 0;
+        int first = 0;
+        int last = 0;
+        bool ordered = true;
+    };
+
+    KeyRun combineRuns(KeyRun a, KeyRun b)
+    {
+        if (a.count == 0) return b;
+        if (b.count == 0) return a;
+        return KeyRun{ a.count + b.count, a.first, b.last, a.ordered && b.ordered && a.last < b.first };
+    }
+
+    /// Degenerate shapes must still be cut into tasks that cover every node once, in key order.
+    template <class Traits>
+    void parallelVisits()
+    {
+        using Tree = SplayTree<KV, std::allocator<KV>, Traits>;
+        const int n = static_cast<int>(Traits::parallelVisitThreshold) * 3;
+        std::mt19937 rng(7);
+
+        Tree ascending, descending, random;
+        for (int i = 0; i < n; i++)
+        {
+            ascending.insert(KV{ i, 1 });      // Each insert leaves the previous root as left child: a left spine
+            descending.insert(KV{ n - i, 1 }); // A right spine
+            random.insert(KV{ static_cast<int>(rng() % (4 * n)), 1 });
+        }
+
+        for (const Tree* tree : { &ascending, &descending, &random })
+        {
+            KeyRun run = tree->parallelReduce(KeyRun(),
+                [](const KV& kv) { return KeyRun{ 1, kv.key, kv.key, true }; }, &combineRuns);
+            CHECK(run.count == tree->nodeCount());
+            CHECK(run.ordered);
+
+            std::atomic<long long> visited{ 0 };
+            tree->parallelForEach([&visited](const KV& kv) { visited += kv.value; });
+            CHECK(visited == tree->nodeCount());
+        }
+    }
+
+    /// A bad_alloc in mergeFrom must leave the tree as it was, on the one-by-one and the relinking path.
+    template <SplayMode Mode>
+    void mergeFromFailure()
+    {
+        using Tree = SplayTree<KV, FailingAllocator<KV>, SumTraits<Mode>>;
+
+        for (size_t batchSize : { 4, 600 })
+        {
+            Tree tree;
+            Reference ref;
+            for (int i = 0; i < 1000; i += 2)
+            {
+                tree.insert(KV{ i, i });
+                ref.emplace(i, i);
+            }
+            const long live = liveAllocations;
+
+            vector<KV> batch;
+            for (size_t i = 0; i < batchSize; i++)
+                batch.push_back(KV{ static_cast<int>(i * 3 + 1), 1 });
+
+            allocationBudget = 2;
+            bool thrown = false;
+            try
+            {
+                tree.mergeFrom(batch);
+            }
+            catch (const std::bad_alloc&)
+            {
+                thrown = true;
+            }
+            allocationBudget = -1;
+
+            CHECK(thrown);
+            CHECK(liveAllocations == live);
+            checkTree(tree, ref);
+        }
+    }
+
+    /// Copies made before anything was allocated must still share one pool, and stay equal.
+    void poolAllocatorCopies()
+    {
+        using Tree = SplayTree<KV, PoolAllocator<KV>, SumTraits<SplayMode::BottomUp>>;
+
+        PoolAllocator<KV> alloc;
+        PoolAllocator<KV> copy(alloc);
+        PoolAllocator<long long> rebound(alloc);
+        CHECK(alloc == copy && alloc == rebound);
+
+        Tree first(alloc);
+        Tree second(copy);
+        first.insert(KV{ 1, 1 });
+        second.insert(KV{ 2, 2 });
+        CHECK(alloc == copy && alloc == rebound);
+        CHECK(first.get_allocator() == second.get_allocator());
+        CHECK(alloc.getPool() == copy.getPool());
+        CHECK(alloc.getPool()->slotsInUse() == 2);
+
+        PoolAllocator<KV> moved(std::move(copy));
+        CHECK(moved == alloc && copy == alloc);
+        CHECK(!(PoolAllocator<KV>() == alloc));
+    }
+
+    /**
+     * @brief Checks the compact tree's contents both ways round against ref, and its shape against twin.
+     */
+    template <class Compact, class Twin>
+    void checkCompact(const Compact& tree, const Twin& twin, const Reference& ref)
+    {
+        CHECK(tree.nodeCount() == static_cast<int>(ref.size()));
+        CHECK(tree.empty() == ref.empty());
+
+        auto it = ref.begin();
+        for (const KV& kv : tree)
+        {
+            if (it == ref.end()) { CHECK(false); break; }
+            CHECK(kv.key == it->first && kv.value == it->second);
+            ++it;
+        }
+        CHECK(it == ref.end());
+
+        auto back = ref.rbegin();
+        for (auto node = tree.end(); node != tree.begin() && back != ref.rend(); ++back)
+        {
+            --node;
+            CHECK(node->key == back->first);
+        }
+        CHECK(back == ref.rend());
+
+        CHECK(tree.height() == twin.height());
+        CHECK(tree.depthProfile() == twin.depthProfile());
+    }
+
+    /// Every public operation of CompactSplayTree against std::map, with stretches of mostly erases.
+    template <SplayMode Mode>
+    void compactRandomOperations(unsigned seed)
+    {
+        using Compact = CompactSplayTree<KV, PlainTraits<Mode>>;
+        using Twin = SplayTree<KV, std::allocator<KV>, PlainTraits<Mode>>;
+
+        std::mt19937 rng(seed);
+        const int keys = 1 + static_cast<int>(rng() % 300);
+        std::uniform_int_distribution<int> key(0, keys);
+        std::uniform_int_distribution<long long> value(-1000, 1000);
+
+        Compact tree;
+        Twin twin;
+        Reference ref;
+        for (int step = 0; step < 600; step++)
+        {
+            const int k = key(rng);
+            const long long v = value(rng);
+            const bool eraseHeavy = (step / 100) % 2 == 1;
+            const unsigned op = eraseHeavy && rng() % 3 != 0 ? 6 : rng() % 16;
+            switch (op)
+            {
+            case 0: case 1:
+            {
+                const KV kv{ k, v };
+                tree.insert(kv);
+                twin.insert(kv);
+                ref.emplace(k, v);
+                break;
+            }
+            case 2:
+                tree.insert(KV{ k, v });
+                twin.insert(KV{ k, v });
+                ref.emplace(k, v);
+                break;
+            case 3:
+            {
+                auto placed = tree.emplace(KV{ k, v });
+                twin.emplace(KV{ k, v });
+                CHECK(placed.second == ref.emplace(k, v).second);
+                CHECK(placed.first->key == k && placed.first->value == ref[k]);
+                break;
+            }
+            case 4:
+            {
+                auto placed = tree.try_emplace(k, KV{ k, v });
+                twin.try_emplace(k, KV{ k, v });
+                CHECK(placed.second == ref.emplace(k, v).second);
+                CHECK(placed.first->value == ref[k]);
+                break;
+            }
+            case 5:
+            {
+                auto placed = tree.insert_or_assign(KV{ k, v });
+                twin.insert_or_assign(KV{ k, v });
+                CHECK(placed.second == (ref.count(k) == 0));
+                ref[k] = v;
+                break;
+            }
+            case 6: case 7:
+                CHECK(tree.erase(k) == (ref.count(k) != 0));
+                twin.erase(k);
+                ref.erase(k);
+                break;
+            case 8:
+            {
+                KV* found = tree.search(k);
+                twin.search(k);
+                CHECK((found != nullptr) == (ref.count(k) != 0));
+                CHECK(!found || (found->key == k && found->value == ref[k]));
+                break;
+            }
+            case 9:
+            {
+                const Compact& view = tree;
+                const KV* found = view.find(k);
+                CHECK(view.contains(k) == (ref.count(k) != 0));
+                CHECK((found != nullptr) == (ref.count(k) != 0));
+                CHECK(!found || found->value == ref[k]);
+                if (KV* stored = tree.peek(k))
+                {
+                    stored->value = v; // Values may change in place as long as the key stays
+                    twin.peek(k)->value = v;
+                    ref[k] = v;
+                }
+                break;
+            }
+            case 10:
+            {
+                const Compact& view = tree;
+                auto lower = view.lower_bound(k);
+                auto upper = view.upper_bound(k);
+                auto refLower = ref.lower_bound(k);
+                auto refUpper = ref.upper_bound(k);
+                CHECK((lower == view.end()) == (refLower == ref.end()));
+                CHECK(lower == view.end() || lower->key == refLower->first);
+                CHECK((upper == view.end()) == (refUpper == ref.end()));
+                CHECK(upper == view.end() || upper->key == refUpper->first);
+                break;
+            }
+            case 11: case 12:
+            {
+                vector<KV> batch;
+                const size_t count = rng() % 2 ? rng() % 6 : rng() % 200;
+                for (size_t i = 0; i < count; i++)
+                    batch.push_back(KV{ key(rng), value(rng) });
+                tree.mergeFrom(batch);
+                twin.mergeFrom(batch);
+                for (const KV& kv : batch)
+                    ref.emplace(kv.key, kv.value);
+                break;
+            }
+            case 13:
+            {
+                vector<KV> all;
+                tree.collectInOrder(all);
+                std::shuffle(all.begin(), all.end(), rng);
+                tree.buildFrom(all);
+                twin.buildFrom(all);
+                break;
+            }
+            case 14:
+            {
+                Compact copy(tree);
+                checkCompact(copy, twin, ref);
+                Compact moved(std::move(copy));
+                CHECK(copy.empty());
+                checkCompact(moved, twin, ref);
+                tree = std::move(moved);
+                break;
+            }
+            default:
+                for (KV& kv : tree)
+                    kv.value++;
+                for (KV& kv : twin)
+                    kv.value++;
+                for (auto& entry : ref)
+                    entry.second++;
+                break;
+            }
+            checkCompact(tree, twin, ref);
+            if (failures)
+            {
+                std::fprintf(stderr, "compact seed %u, step %d, op %u\n", seed, step, op);
+                return;
+            }
+        }
+    }
+
+    template <SplayMode Mode>
+    void randomOperations(unsigned seed)
+    {
+        using Tree = SplayTree<KV, std::allocator<KV>, SumTraits<Mode>>;
+
+        std::mt19937 rng(seed);
+        const int keys = 1 + static_cast<int>(rng() % 200);
+        std::uniform_int_distribution<int> key(0, keys);
+        std::uniform_int_distribution<long long> value(-1000, 1000);
+
+        Tree tree;
+        Reference ref;
+        for (int step = 0; step < 600; step++)
+        {
+            const int k = key(rng);
+            const long long v = value(rng);
+            switch (rng() % 16)
+            {
+            case 0: case 1: case 2:
+                tree.insert(KV{ k, v });
+                ref.emplace(k, v);
+                break;
+            case 3:
+            {
+                bool inserted = tree.emplace(KV{ k, v }).second;
+                CHECK(inserted == ref.emplace(k, v).second);
+                break;
+            }
+            case 4:
+                tree.insert_or_assign(KV{ k, v });
+                ref[k] = v;
+                break;
+            case 5: case 6:
+                CHECK(tree.erase(k) == (ref.erase(k) != 0));
+                break;
+            case 7:
+            {
+                auto* found = tree.search(k);
+                CHECK((found != nullptr) == (ref.count(k) != 0));
+                CHECK(!found || found->data.value == ref[k]);
+                break;
+            }
+            case 8:
+            {
+                auto lower = tree.lower_bound(k);
+                auto upper = tree.upper_bound(k);
+                auto refLower = ref.lower_bound(k);
+                auto refUpper = ref.upper_bound(k);
+                CHECK((lower == tree.end()) == (refLower == ref.end()));
+                CHECK(lower == tree.end() || lower->key == refLower->first);
+                CHECK((upper == tree.end()) == (refUpper == ref.end()));
+                CHECK(upper == tree.end() || upper->key == refUpper->first);
+                break;
+            }
+            case 9:
+            {
+                CHECK(tree.rank(k) == static_cast<size_t>(std::distance(ref.begin(), ref.lower_bound(k))));
+                const size_t index = ref.empty() ? 0 : rng() % (ref.size() + 1);
+                auto selected = tree.select(index);
+                CHECK((selected == tree.end()) == (index == ref.size()));
+                CHECK(selected == tree.end() || selected->key == std::next(ref.begin(), static_cast<ptrdiff_t>(index))->first);
+                break;
+            }
+            case 10:
+            {
+                const int hi = k + key(rng) / 4;
+                CHECK(tree.countInRange(k, hi) == static_cast<size_t>(std::distance(ref.lower_bound(k), ref.upper_bound(hi))));
+                CHECK(tree.aggregateRange(k, hi) == referenceSum(ref, k, hi));
+                break;
+            }
+            case 11:
+            {
+                const int hi = k + key(rng) / 8;
+                size_t expected = static_cast<size_t>(std::distance(ref.lower_bound(k), ref.upper_bound(hi)));
+                CHECK(tree.eraseRange(k, hi) == expected);
+                ref.erase(ref.lower_bound(k), ref.upper_bound(hi));
+                break;
+            }
+            case 12:
+            {
+                Tree upper = tree.split(k);
+                Reference refUpper(ref.lower_bound(k), ref.end());
+                ref.erase(ref.lower_bound(k), ref.end());
+                checkTree(tree, ref);
+                checkTree(upper, refUpper);
+                tree.join(upper);
+                CHECK(upper.empty());
+                ref.insert(refUpper.begin(), refUpper.end());
+                break;
+            }
+            case 13:
+            {
+                // A second tree with overlapping keys takes the merging path of join
+                Tree other;
+                Reference refOther;
+                for (int i = 0; i < 5; i++)
+                {
+                    const int otherKey = key(rng);
+                    other.insert(KV{ otherKey, v + i });
+                    refOther.emplace(otherKey, v + i);
+                }
+                tree.join(other);
+                for (const auto& entry : refOther)
+                    ref.emplace(entry);
+                break;
+            }
+            case 14:
+            {
+                vector<KV> batch;
+                const size_t count = rng() % 40;
+                for (size_t i = 0; i < count; i++)
+                    batch.push_back(KV{ key(rng), value(rng) });
+                tree.mergeFrom(batch);
+                for (const KV& kv : batch)
+                    ref.emplace(kv.key, kv.value);
+                break;
+            }
+            default:
+            {
+                Tree copy(tree);
+                checkTree(copy, ref);
+                if (rng() % 8 == 0)
+                {
+                    vector<KV> all;
+                    tree.collectInOrder(all);
+                    std::shuffle(all.begin(), all.end(), rng);
+                    tree.buildFrom(all);
+                }
+                break;
+            }
+            }
+            checkTree(tree, ref);
+            if (failures)
+            {
+                std::fprintf(stderr, "seed %u, step %d\n", seed, step);
+                return;
+            }
+        }
+    }
+}
+
+int main()
+{
+    singleElementAggregates<SplayMode::BottomUp>();
+    singleElementAggregates<SplayMode::TopDown>();
+    parallelVisits<SumTraits<SplayMode::BottomUp>>();
+    parallelVisits<PlainTraits<>>();
+    mergeFromFailure<SplayMode::BottomUp>();
+    mergeFromFailure<SplayMode::TopDown>();
+    poolAllocatorCopies();
+
+    for (unsigned seed = 1; seed <= 90 && !failures; seed++)
+    {
+        randomOperations<SplayMode::BottomUp>(seed);
+        randomOperations<SplayMode::TopDown>(seed);
+        compactRandomOperations<SplayMode::BottomUp>(seed);
+        compactRandomOperations<SplayMode::TopDown>(seed);
+    }
+
+    if (failures)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}